@@ -0,0 +1,75 @@
+// Measures the cost of recording into sw::async_exporter on the recording thread, with each backpressure policy, while the background thread exports every millisecond. Writing every record to a file on the recording thread is shown for comparison.
+
+#include "async_exporter.hpp"
+#include "common.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace std::literals::chrono_literals;
+
+constexpr int iterations	= 1'000'000;
+constexpr int rounds		= 20;
+
+// Records into an exporter with the given policy, and prints the fraction of records that were lost.
+static void bench_policy(const char* name, sw::backpressure policy) {
+	auto exporter	= sw::async_exporter(1ms, [](const sw::export_batch& b) { bench::do_not_optimize(b.summaries.size()); }, policy);
+	const auto now	= std::chrono::steady_clock::now();
+
+	bench::print_row(name, bench::run(iterations, rounds, [&] { exporter.record("bench", now, 1us); }));
+	exporter.flush();
+
+	std::printf("%-44s %11.1f%%\n", "    lost", 100.0 * static_cast<double>(exporter.lost()) / static_cast<double>(exporter.lost() + exporter.exported()));
+}
+
+int main() {
+	bench::print_header("ns per record");
+
+	bench::print_row("steady_clock::now()", bench::run(iterations, rounds, [] {
+		bench::do_not_optimize(std::chrono::steady_clock::now());
+	}));
+
+	bench_policy("record(), drop", sw::backpressure::drop);
+	bench_policy("record(), overwrite", sw::backpressure::overwrite);
+	bench_policy("record(), block", sw::backpressure::block);
+
+	{
+		auto exporter = sw::async_exporter(1ms, [](const sw::export_batch&) {});
+
+		bench::print_row("trace()", bench::run(iterations, rounds, [&] {
+			auto t = exporter.trace("bench");
+			bench::do_not_optimize(t);
+		}));
+	}
+
+	// Each thread has its own queue, so recording threads don't contend with each other. With fewer cores than threads, this includes the time the others run
+	{
+		auto exporter	= sw::async_exporter(1ms, [](const sw::export_batch&) {});
+		auto stop		= std::atomic<bool>();
+		auto others		= std::vector<std::thread>();
+
+		for (int t{}; t < 2; t++) {
+			others.emplace_back([&] {
+				while (!stop.load(std::memory_order_relaxed)) exporter.record("other", std::chrono::steady_clock::now(), 1us);
+			});
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+
+		bench::print_row("record(), 2 other recording threads", bench::run(iterations, rounds, [&] { exporter.record("bench", now, 1us); }));
+
+		stop = true;
+		for (auto& t : others) t.join();
+	}
+
+	{
+		auto file		= std::tmpfile();
+		const auto now	= std::chrono::steady_clock::now().time_since_epoch().count();
+
+		bench::print_row("fprintf() to a file", bench::run(iterations, rounds, [&] {
+			std::fprintf(file, "%s\t%lld\t%lld\n", "bench", static_cast<long long>(now), 1000LL);
+		}));
+
+		std::fclose(file);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+// Small helpers shared by the benchmarks. Not part of the library.
+
+#ifndef _A_BENCH_COMMON_HPP_
+#define _A_BENCH_COMMON_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+	// Keeps the compiler from optimizing away a value.
+	template <typename T>
+	inline void do_not_optimize(const T& value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const T* sink;
+		sink = &value;
+#endif
+	}
+
+	// Calls `body` `iterations` times in each of `rounds` rounds, and returns the mean time of a call in each round, in nanoseconds.
+	template <typename Body>
+	std::vector<double> run(int iterations, int rounds, Body&& body) {
+		auto samples = std::vector<double>();
+
+		for (int r{}; r < rounds; r++) {
+			auto timer = sw::stopwatch();
+
+			timer.start();
+			for (int i{}; i < iterations; i++) body();
+			samples.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / iterations);
+		}
+
+		return samples;
+	}
+
+	// Returns the value at quantile `q` (0 to 1) of an already sorted list.
+	inline double quantile(const std::vector<double>& sorted, double q) noexcept {
+		if (sorted.empty()) return 0.0;
+
+		return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * static_cast<double>(sorted.size())))];
+	}
+
+	// Prints the header that matches print_row().
+	inline void print_header(const char* unit) {
+		std::printf("%-44s %12s %12s %12s %12s %12s   (%s)\n", "", "min", "median", "p99", "max", "mean", unit);
+	}
+
+	// Prints a one-line summary of the samples.
+	inline void print_row(const char* name, std::vector<double> samples) {
+		std::sort(samples.begin(), samples.end());
+
+		double sum{};
+		for (auto s : samples) sum += s;
+
+		std::printf("%-44s %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+			name,
+			quantile(samples, 0.0),
+			quantile(samples, 0.5),
+			quantile(samples, 0.99),
+			samples.empty() ? 0.0 : samples.back(),
+			samples.empty() ? 0.0 : sum / static_cast<double>(samples.size()));
+	}
+}
+
+#endif
\ No newline at end of file
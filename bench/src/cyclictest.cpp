@@ -0,0 +1,161 @@
+// Measures the wake-up latency of the OS, like cyclictest does. Each thread is pinned to a CPU and wakes up periodically at absolute deadlines; the time between a deadline and the actual wake-up is recorded into a histogram per thread.
+//
+// Options:
+//   -t <threads>     Number of threads (default: the number of CPUs, at most 4)
+//   -i <us>          Wake-up interval in microseconds (default: 1000)
+//   -d <seconds>     How long to run (default: 2)
+//   -p <priority>    Run the threads with SCHED_FIFO at this priority, if permitted (default: off)
+//   -m               Lock the memory of the process with mlockall(), if permitted
+
+#include "common.hpp"
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+
+struct settings {
+	int							threads{ static_cast<int>(std::min(4u, std::max(1u, std::thread::hardware_concurrency()))) };
+	std::chrono::microseconds	interval{ 1000 };
+	std::chrono::seconds		duration{ 2 };
+	int							priority{};
+	bool						lock_memory{};
+};
+
+struct thread_result {
+	sw::duration_histogram	latency;
+	int						cpu{ -1 };
+	bool					fifo{};
+};
+
+// Sleeps until an absolute deadline. On Linux, std::chrono::steady_clock is CLOCK_MONOTONIC, so the deadline can be passed to clock_nanosleep() as is.
+static void sleep_until(std::chrono::steady_clock::time_point deadline) {
+#ifdef __linux__
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+	timespec ts{};
+	ts.tv_sec	= static_cast<time_t>(ns / 1'000'000'000);
+	ts.tv_nsec	= static_cast<long>(ns % 1'000'000'000);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+	std::this_thread::sleep_until(deadline);
+#endif
+}
+
+static void measure(int index, const settings& s, std::atomic<int>& ready, thread_result& result) {
+#ifdef __linux__
+	const auto cpu = index % static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) result.cpu = cpu;
+
+	if (s.priority > 0) {
+		sched_param param{};
+		param.sched_priority = s.priority;
+
+		result.fifo = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+	}
+#else
+	(void)index;
+#endif
+
+	// Every thread starts at the same time
+	ready--;
+	while (ready > 0) std::this_thread::yield();
+
+	const auto start	= std::chrono::steady_clock::now();
+	auto next			= start + s.interval;
+
+	while (next - start < s.duration) {
+		sleep_until(next);
+
+		const auto now = std::chrono::steady_clock::now();
+
+		result.latency.record(now - next);
+
+		// Wake-ups that were missed entirely are skipped, so a long stall doesn't cause a burst of wake-ups
+		next += s.interval;
+		while (next <= now) next += s.interval;
+	}
+}
+
+static void print_row(const std::string& name, const sw::duration_histogram& h) {
+	const auto us = [](auto d) { return sw::convert_time<sw::d_microseconds>(d).count(); };
+
+	std::printf("%-24s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+		name.c_str(),
+		static_cast<unsigned long long>(h.count()),
+		us(h.min()),
+		us(h.mean()),
+		us(h.quantile(0.99)),
+		us(h.quantile(0.9999)),
+		us(h.max()));
+}
+
+int main(int argc, char** argv) {
+	auto s = settings();
+
+	for (int i = 1; i < argc; i++) {
+		const auto arg		= std::string(argv[i]);
+		const auto value	= [&] { return i + 1 < argc ? std::atoi(argv[++i]) : 0; };
+
+		if		(arg == "-t") s.threads		= std::max(1, value());
+		else if (arg == "-i") s.interval	= std::chrono::microseconds(std::max(1, value()));
+		else if (arg == "-d") s.duration	= std::chrono::seconds(std::max(1, value()));
+		else if (arg == "-p") s.priority	= value();
+		else if (arg == "-m") s.lock_memory	= true;
+		else {
+			std::printf("Unknown option: %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+#ifdef __linux__
+	if (s.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) std::printf("mlockall() failed: %s\n", std::strerror(errno));
+#endif
+
+	std::printf("%d threads, %lld us interval, %lld s\n\n", s.threads, static_cast<long long>(s.interval.count()), static_cast<long long>(s.duration.count()));
+
+	auto results	= std::vector<thread_result>(static_cast<std::size_t>(s.threads));
+	auto threads	= std::vector<std::thread>();
+	auto ready		= std::atomic<int>(s.threads);
+
+	for (int i{}; i < s.threads; i++) threads.emplace_back(measure, i, std::cref(s), std::ref(ready), std::ref(results[static_cast<std::size_t>(i)]));
+	for (auto& t : threads) t.join();
+
+	std::printf("%-24s %10s %10s %10s %10s %10s %10s   (latency in us)\n", "", "wake-ups", "min", "avg", "p99", "p99.99", "max");
+
+	auto all = sw::duration_histogram();
+
+	for (std::size_t i{}; i < results.size(); i++) {
+		const auto& r = results[i];
+
+		auto name = "T" + std::to_string(i);
+		name += r.cpu >= 0 ? " (cpu " + std::to_string(r.cpu) : " (unpinned";
+		name += r.fifo ? ", fifo)" : ")";
+
+		print_row(name, r.latency);
+		all.merge(r.latency);
+	}
+
+	print_row("all", all);
+
+	if (s.priority > 0 && !std::all_of(results.begin(), results.end(), [](const auto& r) { return r.fifo; })) {
+		std::printf("\nSCHED_FIFO was not permitted for some threads (this needs root or CAP_SYS_NICE)\n");
+	}
+}
\ No newline at end of file
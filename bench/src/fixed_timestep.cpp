@@ -0,0 +1,39 @@
+// Measures the overhead of sw::fixed_timestep per frame, compared with a plain stopwatch lap.
+
+#include "common.hpp"
+#include "fixed_timestep.hpp"
+
+using namespace std::literals::chrono_literals;
+
+constexpr int runs		= 10;
+constexpr int frames	= 1'000'000;
+
+int main() {
+	auto timer		= sw::stopwatch();
+	auto laps		= std::vector<double>();
+	auto steps		= std::vector<double>();
+
+	for (int run{}; run < runs; run++) {
+		auto lap = sw::stopwatch();
+
+		timer.start();
+		for (int i{}; i < frames; i++) bench::do_not_optimize(lap.start());
+		laps.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / frames);
+
+		// A tiny step makes sure updates actually run in most frames
+		auto stepper = sw::fixed_timestep(20ns, 8);
+		std::uint64_t updates{};
+
+		timer.start();
+		for (int i{}; i < frames; i++) stepper.frame([&](auto) { updates++; });
+		steps.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / frames);
+
+		bench::do_not_optimize(updates);
+		bench::do_not_optimize(stepper.alpha());
+	}
+
+	std::printf("%d runs of %d frames\n\n", runs, frames);
+	bench::print_header("ns per frame");
+	bench::print_row("stopwatch::start() lap", laps);
+	bench::print_row("fixed_timestep::frame()", steps);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+// Runs sw::hiccup_meter for a few seconds and prints the stalls of the process per interval, first idle, then while another thread keeps touching fresh memory (which causes page faults).
+
+#include "common.hpp"
+#include "hiccup_meter.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+using namespace std::literals::chrono_literals;
+
+int main() {
+	const auto start = std::chrono::steady_clock::now();
+
+	auto meter = sw::hiccup_meter(1ms, 250ms, [&](const sw::hiccup_meter::interval_report& r) {
+		const auto us = [](std::chrono::nanoseconds d) { return sw::convert_time<sw::d_microseconds>(d).count(); };
+
+		std::printf("%8.2f %10llu %12.1f %12.1f %12.1f %12.1f\n",
+			sw::convert_time<sw::d_seconds>(r.end - start).count(),
+			static_cast<unsigned long long>(r.hiccups.count()),
+			us(r.hiccups.quantile(0.5)),
+			us(r.hiccups.quantile(0.99)),
+			us(r.hiccups.quantile(0.999)),
+			us(r.hiccups.max()));
+	});
+
+	std::printf("%8s %10s %12s %12s %12s %12s   (us)\n", "time s", "samples", "p50", "p99", "p99.9", "max");
+
+	meter.start();
+	std::this_thread::sleep_for(1s);
+
+	std::printf("-- allocating\n");
+
+	auto stop	= std::atomic<bool>();
+	auto load	= std::thread([&] {
+		while (!stop) {
+			auto block = std::make_unique<char[]>(64 << 20);
+			std::memset(block.get(), 1, 64 << 20);
+			bench::do_not_optimize(block[12345]);
+		}
+	});
+
+	std::this_thread::sleep_for(1s);
+
+	stop = true;
+	load.join();
+	meter.stop();
+
+	const auto totals = meter.totals();
+
+	std::printf("\nTotal: %llu samples, p99.9 %.1f us, max %.1f us\n",
+		static_cast<unsigned long long>(totals.count()),
+		sw::convert_time<sw::d_microseconds>(totals.quantile(0.999)).count(),
+		sw::convert_time<sw::d_microseconds>(totals.max()).count());
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+// Measures the encoding and decoding speed of sw::lap_log, and the bytes it takes per lap, for laps of different regularity. A lap takes 16 bytes uncompressed.
+
+#include "common.hpp"
+#include "lap_log.hpp"
+
+#include <random>
+
+constexpr int lap_count	= 1'000'000;
+constexpr int rounds	= 10;
+
+template <typename Duration>
+void run(const char* name, Duration&& next_duration) {
+	auto laps = std::vector<sw::lap_record>();
+
+	std::int64_t t = 1'000'000'000'000;
+
+	for (int i{}; i < lap_count; i++) {
+		const auto d = next_duration();
+
+		t += d;
+		laps.push_back({ t, d });
+	}
+
+	auto encode	= std::vector<double>();
+	auto decode	= std::vector<double>();
+	auto log	= sw::lap_log();
+
+	for (int r{}; r < rounds; r++) {
+		auto timer = sw::stopwatch();
+
+		log.clear();
+
+		timer.start();
+		for (const auto& lap : laps) log.append(lap.timestamp_ns, lap.duration_ns);
+		encode.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / lap_count);
+
+		auto reader = sw::lap_log_reader(log);
+		auto lap	= sw::lap_record();
+		std::int64_t sum{};
+
+		timer.start();
+		while (reader.next(lap)) sum += lap.duration_ns;
+		decode.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / lap_count);
+
+		bench::do_not_optimize(sum);
+	}
+
+	std::printf("\n%s: %.2f bytes per lap\n", name, static_cast<double>(log.used_bytes()) / lap_count);
+	bench::print_row("  encode", encode);
+	bench::print_row("  decode", decode);
+}
+
+int main() {
+	auto rng = std::mt19937_64(42);
+
+	bench::print_header("ns per lap");
+
+	run("Constant 1 ms laps", [] { return std::int64_t{ 1'000'000 }; });
+
+	run("1 ms laps with 1 us of jitter", [&, d = std::uniform_int_distribution<std::int64_t>(-1'000, 1'000)]() mutable {
+		return 1'000'000 + d(rng);
+	});
+
+	run("1 ms laps with 100 us of jitter", [&, d = std::uniform_int_distribution<std::int64_t>(-100'000, 100'000)]() mutable {
+		return 1'000'000 + d(rng);
+	});
+
+	run("Log-normal laps around 50 us", [&, d = std::lognormal_distribution<double>(10.8, 1.0)]() mutable {
+		return static_cast<std::int64_t>(d(rng));
+	});
+}
\ No newline at end of file
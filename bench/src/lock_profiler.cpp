@@ -0,0 +1,53 @@
+// Measures the overhead of sw::timed_mutex_wrapper over a plain std::mutex, uncontended and with every available thread competing for the lock.
+
+#include "common.hpp"
+#include "lock_profiler.hpp"
+
+#include <iostream>
+#include <thread>
+
+constexpr int ops_per_thread = 1'000'000;
+
+template <typename Lock>
+double run(Lock& m, int thread_count) {
+	auto threads	= std::vector<std::thread>();
+	auto timer		= sw::stopwatch();
+	std::uint64_t counter{};
+
+	timer.start();
+
+	for (int t{}; t < thread_count; t++) {
+		threads.emplace_back([&] {
+			for (int i{}; i < ops_per_thread; i++) {
+				std::lock_guard<Lock> lock(m);
+				counter++;
+			}
+
+			sw::flush_lock_stats();
+		});
+	}
+
+	for (auto& t : threads) t.join();
+
+	bench::do_not_optimize(counter);
+
+	return timer.get_elapsed<sw::d_nanoseconds>().count() / (static_cast<double>(ops_per_thread) * thread_count);
+}
+
+int main() {
+	const auto hw = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+
+	std::printf("%-36s %16s %16s\n", "", "1 thread (ns)", "contended (ns)");
+
+	auto plain		= std::mutex();
+	auto full		= sw::timed_mutex_wrapper<>("bench full");
+	auto sampling	= sw::timed_mutex_wrapper<>("bench sampling", sw::lock_timing::sampling);
+
+	std::printf("%-36s %16.1f %16.1f\n", "std::mutex", run(plain, 1), run(plain, hw));
+	std::printf("%-36s %16.1f %16.1f\n", "timed_mutex_wrapper, full", run(full, 1), run(full, hw));
+	std::printf("%-36s %16.1f %16.1f\n", "timed_mutex_wrapper, sampling", run(sampling, 1), run(sampling, hw));
+
+	std::printf("\n%d threads in the contended runs\n\n", hw);
+
+	sw::write_contention_report(std::cout);
+}
\ No newline at end of file
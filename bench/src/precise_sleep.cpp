@@ -0,0 +1,49 @@
+// Compares the wake-up error of std::this_thread::sleep_for() and sw::precise_sleep_for() with different spin budgets.
+
+#include "common.hpp"
+#include "precise_sleep.hpp"
+
+#include <ctime>
+#include <string>
+
+using namespace std::literals::chrono_literals;
+
+constexpr int iterations = 200;
+
+template <typename Sleep>
+void run(const std::string& name, std::chrono::microseconds target, Sleep&& sleep) {
+	auto errors		= std::vector<double>();
+	auto timer		= sw::stopwatch();
+	auto cpu_start	= std::clock();
+
+	errors.reserve(iterations);
+
+	for (int i{}; i < iterations; i++) {
+		timer.start();
+		sleep(target);
+		errors.push_back((timer.get_elapsed<sw::d_microseconds>() - target).count());
+	}
+
+	const auto cpu_ms		= 1000.0 * static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+	const auto wall_ms		= static_cast<double>(iterations) * sw::convert_time<sw::d_milliseconds>(target).count();
+	const auto row_name		= name + " (cpu " + std::to_string(static_cast<int>(100.0 * cpu_ms / wall_ms)) + "%)";
+
+	bench::print_row(row_name.c_str(), errors);
+}
+
+int main() {
+	// Warming up the calibration
+	sw::precise_sleep_for(100ms);
+
+	for (auto target : { 100us, 500us, 1000us, 5000us }) {
+		std::printf("\nTarget: %d us\n", static_cast<int>(target.count()));
+		bench::print_header("error in us");
+
+		run("std::this_thread::sleep_for", target, [](auto d) { std::this_thread::sleep_for(d); });
+		run("sw::precise_sleep_for, budget 0", target, [](auto d) { sw::precise_sleep_for(d, 0us); });
+		run("sw::precise_sleep_for, budget 200us", target, [](auto d) { sw::precise_sleep_for(d, 200us); });
+		run("sw::precise_sleep_for, unlimited", target, [](auto d) { sw::precise_sleep_for(d); });
+	}
+
+	std::printf("\nCalibrated sleep estimate: %.1f us\n", sw::convert_time<sw::d_microseconds>(sw::sleep_calibration::this_thread().estimate()).count());
+}
\ No newline at end of file
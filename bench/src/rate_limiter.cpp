@@ -0,0 +1,101 @@
+// Measures the throughput of sw::token_bucket and sw::gcra from multiple threads, compared with a mutex-protected token bucket. Covers a single shared limiter, and 10,000 per-tenant limiters picked at random.
+
+#include "common.hpp"
+#include "rate_limiter.hpp"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int ops_per_thread	= 2'000'000;
+constexpr int tenant_count		= 10'000;
+
+// The usual implementation: a mutex, and the clock read on every check
+class mutex_token_bucket {
+public:
+	mutex_token_bucket(double tokens_per_second, std::uint32_t capacity) :
+		m_rate{ tokens_per_second / 1e9 },
+		m_capacity{ static_cast<double>(capacity) },
+		m_tokens{ m_capacity },
+		m_last{ clock_type::now() }
+	{}
+
+	bool try_acquire() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const auto now = clock_type::now();
+
+		m_tokens	= std::min(m_capacity, m_tokens + m_rate * static_cast<double>((now - m_last).count()));
+		m_last		= now;
+
+		if (m_tokens < 1.0) return false;
+
+		m_tokens -= 1.0;
+		return true;
+	}
+
+private:
+	std::mutex				m_mutex;
+	double					m_rate;
+	double					m_capacity;
+	double					m_tokens;
+	clock_type::time_point	m_last;
+};
+
+template <typename Limiter, typename Factory>
+void run(const char* name, Factory&& make, int thread_count, int limiter_count) {
+	auto limiters = std::vector<std::unique_ptr<Limiter>>();
+
+	for (int i{}; i < limiter_count; i++) limiters.push_back(make());
+
+	auto threads	= std::vector<std::thread>();
+	auto allowed	= std::vector<int>(static_cast<std::size_t>(thread_count));
+	auto timer		= sw::stopwatch();
+
+	timer.start();
+
+	for (int t{}; t < thread_count; t++) {
+		threads.emplace_back([&, t] {
+			std::uint32_t rng = 2463534242u + static_cast<std::uint32_t>(t);
+			int count{};
+
+			for (int i{}; i < ops_per_thread; i++) {
+				rng ^= rng << 13;
+				rng ^= rng >> 17;
+				rng ^= rng << 5;
+
+				if (limiters[rng % static_cast<std::uint32_t>(limiter_count)]->try_acquire()) count++;
+			}
+
+			allowed[static_cast<std::size_t>(t)] = count;
+		});
+	}
+
+	for (auto& t : threads) t.join();
+
+	const auto seconds	= timer.get_elapsed<sw::d_seconds>().count();
+	const auto total	= static_cast<double>(ops_per_thread) * thread_count;
+
+	int allowed_total{};
+	for (auto a : allowed) allowed_total += a;
+
+	std::printf("%-24s %8d %10d %14.1f %12.1f\n", name, thread_count, limiter_count, total / seconds / 1e6, 100.0 * allowed_total / total);
+}
+
+int main() {
+	const auto hw = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+	std::printf("%-24s %8s %10s %14s %12s\n", "", "threads", "limiters", "Mchecks/s", "allowed %");
+
+	for (int limiters : { 1, tenant_count }) {
+		for (int threads = 1; threads <= hw; threads *= 2) {
+			run<mutex_token_bucket>("mutex token bucket", [] { return std::make_unique<mutex_token_bucket>(1e6, 1000); }, threads, limiters);
+			run<sw::token_bucket>("sw::token_bucket", [] { return std::make_unique<sw::token_bucket>(1e6, 1000); }, threads, limiters);
+			run<sw::gcra>("sw::gcra", [] { return std::make_unique<sw::gcra>(std::chrono::microseconds(1), 1000); }, threads, limiters);
+		}
+
+		std::printf("\n");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+// Measures the added cost of sw::rusage_stopwatch over sw::stopwatch, for a start and pause pair, and for reading the resource usage.
+
+#include "common.hpp"
+#include "rusage_stopwatch.hpp"
+
+constexpr int iterations	= 200'000;
+constexpr int rounds		= 20;
+
+int main() {
+	auto plain	= sw::stopwatch();
+	auto rusage	= sw::rusage_stopwatch();
+
+	bench::print_header("ns per operation");
+
+	bench::print_row("stopwatch start() + pause()", bench::run(iterations, rounds, [&] {
+		plain.start();
+		plain.pause();
+	}));
+
+	bench::print_row("rusage_stopwatch start() + pause()", bench::run(iterations, rounds, [&] {
+		rusage.start();
+		rusage.pause();
+	}));
+
+	rusage.start();
+
+	bench::print_row("rusage_stopwatch get_usage() while running", bench::run(iterations, rounds, [&] {
+		bench::do_not_optimize(rusage.get_usage());
+	}));
+
+	bench::print_row("this_thread_resource_usage()", bench::run(iterations, rounds, [] {
+		bench::do_not_optimize(sw::this_thread_resource_usage());
+	}));
+}
\ No newline at end of file
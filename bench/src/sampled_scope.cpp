@@ -0,0 +1,62 @@
+// Measures the cost of timing a short function with sw::sampled_timer, compared with not timing it and with timing every call with a stopwatch.
+
+#include "common.hpp"
+#include "sampled_scope.hpp"
+
+constexpr int iterations	= 1'000'000;
+constexpr int rounds		= 20;
+
+// Some work that takes a few tens of nanoseconds.
+static void work() {
+	std::uint64_t x{ 1 };
+
+	for (int i{}; i < 32; i++) {
+		x = x * 6364136223846793005 + 1442695040888963407;
+		bench::do_not_optimize(x);
+	}
+}
+
+int main() {
+	bench::print_header("ns per call");
+
+	bench::print_row("not timed", bench::run(iterations, rounds, [] { work(); }));
+
+	{
+		auto stats = sw::duration_histogram();
+
+		bench::print_row("stopwatch, every call", bench::run(iterations, rounds, [&] {
+			auto timer = sw::stopwatch();
+
+			timer.start();
+			work();
+			stats.record(timer.get_elapsed());
+		}));
+
+		bench::do_not_optimize(stats.count());
+	}
+
+	{
+		auto timer = sw::sampled_timer(64);
+
+		bench::print_row("sampled 1 in 64", bench::run(iterations, rounds, [&] {
+			auto scope = timer.measure();
+			work();
+		}));
+
+		bench::do_not_optimize(timer.stats().count());
+	}
+
+	{
+		auto settings				= sw::adaptive_sampling();
+		settings.target_overhead	= 0.01;
+
+		auto timer = sw::sampled_timer(settings);
+
+		bench::print_row("adaptive, 1% target", bench::run(iterations, rounds, [&] {
+			auto scope = timer.measure();
+			work();
+		}));
+
+		std::printf("\nAdaptive period: %u\n", timer.period());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Measures the cost of false sharing: threads restarting their own stopwatch in a plain array, where neighbors share cache lines, compared with sw::stopwatch_array, where each has its own line. The difference only shows with as many cores as threads.
+
+#include "common.hpp"
+#include "stopwatch_array.hpp"
+
+#include <thread>
+
+constexpr int iterations	= 1'000'000;
+constexpr int rounds		= 10;
+constexpr int threads		= 4;
+
+// Runs `body(index)` on every thread at once, and returns the time per call of each round.
+template <typename Body>
+std::vector<double> run(Body&& body) {
+	auto samples = std::vector<double>();
+
+	for (int r{}; r < rounds; r++) {
+		auto timer		= sw::stopwatch();
+		auto workers	= std::vector<std::thread>();
+
+		timer.start();
+
+		for (int t{}; t < threads; t++) {
+			workers.emplace_back([&body, t] {
+				for (int i{}; i < iterations; i++) body(t);
+			});
+		}
+
+		for (auto& w : workers) w.join();
+
+		samples.push_back(timer.get_elapsed<sw::d_nanoseconds>().count() / iterations);
+	}
+
+	return samples;
+}
+
+int main() {
+	std::printf("%d threads, %u hardware threads\n\n", threads, std::thread::hardware_concurrency());
+
+	bench::print_header("ns per lap per thread");
+
+	{
+		auto plain = std::vector<sw::stopwatch>(threads);
+
+		bench::print_row("std::vector<sw::stopwatch>", run([&](int t) {
+			bench::do_not_optimize(plain[t].start());
+		}));
+	}
+
+	{
+		auto aligned = sw::stopwatch_array(threads);
+
+		bench::print_row("sw::stopwatch_array", run([&](int t) {
+			bench::do_not_optimize(aligned[t].start());
+		}));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Measures the cost of a lap (start() on a running stopwatch) with every combination of basic_stopwatch policies, on one thread. The size of each stopwatch is in parentheses.
+
+#include "common.hpp"
+#include "stopwatch_policies.hpp"
+
+constexpr int iterations	= 1'000'000;
+constexpr int rounds		= 20;
+
+template <typename... Policies>
+static void bench_policies(const char* storage, const char* sync, const char* laps) {
+	using timer_type = sw::basic_stopwatch<std::chrono::steady_clock, Policies...>;
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "%s, %s, %s (%zu B)", storage, sync, laps, sizeof(timer_type));
+
+	auto timer = timer_type();
+
+	timer.start();
+
+	bench::print_row(name, bench::run(iterations, rounds, [&] {
+		bench::do_not_optimize(timer.start());
+	}));
+}
+
+// atomic_sync needs packed_storage, so split_storage skips it.
+template <typename Storage>
+static void bench_storage(const char* storage) {
+	bench_policies<Storage, sw::no_sync, sw::no_laps>				(storage, "no_sync", "no_laps");
+	bench_policies<Storage, sw::no_sync, sw::lap_accumulator>		(storage, "no_sync", "lap_accumulator");
+	bench_policies<Storage, sw::no_sync, sw::lap_histogram>			(storage, "no_sync", "lap_histogram");
+
+	if constexpr (std::is_same_v<Storage, sw::packed_storage>) {
+		bench_policies<Storage, sw::atomic_sync, sw::no_laps>		(storage, "atomic_sync", "no_laps");
+		bench_policies<Storage, sw::atomic_sync, sw::lap_accumulator>	(storage, "atomic_sync", "lap_accumulator");
+		bench_policies<Storage, sw::atomic_sync, sw::lap_histogram>	(storage, "atomic_sync", "lap_histogram");
+	}
+
+	bench_policies<Storage, sw::seqlock_sync, sw::no_laps>			(storage, "seqlock_sync", "no_laps");
+	bench_policies<Storage, sw::seqlock_sync, sw::lap_accumulator>	(storage, "seqlock_sync", "lap_accumulator");
+	bench_policies<Storage, sw::seqlock_sync, sw::lap_histogram>	(storage, "seqlock_sync", "lap_histogram");
+}
+
+int main() {
+	bench::print_header("ns per lap");
+
+	bench::print_row("steady_clock::now()", bench::run(iterations, rounds, [] {
+		bench::do_not_optimize(std::chrono::steady_clock::now());
+	}));
+
+	bench::print_row("sw::stopwatch", bench::run(iterations, rounds, [timer = sw::stopwatch()]() mutable {
+		bench::do_not_optimize(timer.start());
+	}));
+
+	bench_storage<sw::split_storage>("split");
+	bench_storage<sw::packed_storage>("packed");
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+// Measures the overhead sw::task_timing adds to each task of a simple thread pool, and prints the queue delay and run time it records.
+
+#include "common.hpp"
+#include "task_timing.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+constexpr int task_count = 1'000'000;
+
+// A minimal thread pool with a single shared queue
+class thread_pool {
+public:
+	thread_pool(std::size_t workers, sw::task_timing* timing) {
+		for (std::size_t i{}; i < workers; i++) {
+			m_threads.emplace_back([this, i, timing] {
+				if (timing) timing->attach_worker(i);
+				work();
+			});
+		}
+	}
+
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_cv.notify_all();
+		for (auto& t : m_threads) t.join();
+	}
+
+	void push(std::function<void()> task) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push_back(std::move(task));
+		}
+
+		m_cv.notify_one();
+	}
+
+private:
+	std::mutex							m_mutex;
+	std::condition_variable				m_cv;
+	std::deque<std::function<void()>>	m_queue;
+	std::vector<std::thread>			m_threads;
+	bool								m_stop{};
+
+	void work() {
+		while (true) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+
+			if (m_queue.empty()) return;
+
+			auto task = std::move(m_queue.front());
+			m_queue.pop_front();
+			lock.unlock();
+
+			task();
+		}
+	}
+};
+
+// Returns the wall time per task, in ns, of pushing every task and waiting for the pool to finish them
+template <typename Push>
+double run(std::size_t workers, sw::task_timing* timing, Push&& push) {
+	std::atomic<int> done{};
+	auto timer = sw::stopwatch();
+
+	timer.start();
+
+	{
+		auto pool = thread_pool(workers, timing);
+
+		for (int i{}; i < task_count; i++) push(pool, [&done] { done.fetch_add(1, std::memory_order_relaxed); });
+	}
+
+	bench::do_not_optimize(done);
+
+	return timer.get_elapsed<sw::d_nanoseconds>().count() / task_count;
+}
+
+int main() {
+	const auto workers = std::max<std::size_t>(2, std::thread::hardware_concurrency());
+
+	// Wrapping and calling a task directly, without a pool. Most of the cost is the three clock reads, so their cost is shown too.
+	{
+		auto timer = sw::stopwatch();
+		std::int64_t sum{};
+
+		timer.start();
+		for (int i{}; i < task_count; i++) sum += std::chrono::steady_clock::now().time_since_epoch().count();
+		const auto now_cost = timer.get_elapsed<sw::d_nanoseconds>().count() / task_count;
+
+		bench::do_not_optimize(sum);
+
+		std::printf("steady_clock::now(): %.1f ns\n", now_cost);
+	}
+
+	{
+		auto timing = sw::task_timing(1);
+		auto timer	= sw::stopwatch();
+		int counter{};
+
+		timer.start();
+		for (int i{}; i < task_count; i++) timing.wrap([&counter] { counter++; })();
+		const auto wrapped = timer.get_elapsed<sw::d_nanoseconds>().count() / task_count;
+
+		bench::do_not_optimize(counter);
+
+		std::printf("wrap() and call, no pool: %.1f ns per task\n\n", wrapped);
+	}
+
+	auto timing = sw::task_timing(workers);
+
+	const auto plain = run(workers, nullptr, [](thread_pool& pool, auto task) { pool.push(std::move(task)); });
+	const auto timed = run(workers, &timing, [&](thread_pool& pool, auto task) { pool.push(timing.wrap(std::move(task))); });
+
+	std::printf("%zu workers, %d tasks\n", workers, task_count);
+	std::printf("  plain tasks: %8.1f ns per task\n", plain);
+	std::printf("  timed tasks: %8.1f ns per task (%+.1f ns)\n\n", timed, timed - plain);
+
+	const auto s	= timing.stats();
+	const auto us	= [](std::chrono::nanoseconds d) { return sw::convert_time<sw::d_microseconds>(d).count(); };
+
+	std::printf("%-12s %12s %12s %12s %12s   (us)\n", "", "p50", "p99", "p99.9", "max");
+	std::printf("%-12s %12.3f %12.3f %12.3f %12.3f\n", "queue delay", us(s.queue_delay.quantile(0.5)), us(s.queue_delay.quantile(0.99)), us(s.queue_delay.quantile(0.999)), us(s.queue_delay.max()));
+	std::printf("%-12s %12.3f %12.3f %12.3f %12.3f\n", "run time", us(s.run_time.quantile(0.5)), us(s.run_time.quantile(0.99)), us(s.run_time.quantile(0.999)), us(s.run_time.max()));
+}
\ No newline at end of file
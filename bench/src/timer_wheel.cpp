@@ -0,0 +1,155 @@
+// Compares sw::timer_wheel with a std::priority_queue based scheduler, using 1M timeouts of which 90% get cancelled before they expire.
+
+#include "common.hpp"
+#include "timer_wheel.hpp"
+
+#include <queue>
+#include <random>
+
+using namespace std::literals::chrono_literals;
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int	timer_count		= 1'000'000;
+constexpr auto	max_timeout		= 30s;
+constexpr auto	step			= 1ms;
+
+struct result {
+	double insert_ns;
+	double cancel_ns;
+	double expire_ns;
+	std::size_t expired;
+};
+
+// Lazy cancellation is the usual way to cancel from a binary heap
+class heap_scheduler {
+public:
+	int schedule_at(clock_type::time_point t) {
+		const auto id = static_cast<int>(m_cancelled.size());
+
+		m_cancelled.push_back(false);
+		m_queue.push({ t, id });
+
+		return id;
+	}
+
+	void cancel(int id) {
+		m_cancelled[static_cast<std::size_t>(id)] = true;
+	}
+
+	template <typename Callback>
+	std::size_t advance(clock_type::time_point now, Callback&& on_expired) {
+		std::size_t count{};
+
+		while (!m_queue.empty() && m_queue.top().first <= now) {
+			const auto id = m_queue.top().second;
+			m_queue.pop();
+
+			if (m_cancelled[static_cast<std::size_t>(id)]) continue;
+
+			on_expired(id);
+			count++;
+		}
+
+		return count;
+	}
+
+private:
+	using entry = std::pair<clock_type::time_point, int>;
+
+	std::priority_queue<entry, std::vector<entry>, std::greater<entry>>	m_queue;
+	std::vector<bool>													m_cancelled;
+};
+
+template <typename Scheduler, typename Id>
+result run(Scheduler& scheduler, const std::vector<clock_type::time_point>& deadlines, clock_type::time_point origin) {
+	auto timer	= sw::stopwatch();
+	auto ids	= std::vector<Id>();
+	auto ret	= result{};
+
+	ids.reserve(deadlines.size());
+
+	timer.start();
+	for (std::size_t i{}; i < deadlines.size(); i++) ids.push_back(scheduler.schedule_at(deadlines[i], static_cast<int>(i)));
+	ret.insert_ns = timer.start<sw::d_nanoseconds>().count() / deadlines.size();
+
+	std::size_t cancelled{};
+	for (std::size_t i{}; i < ids.size(); i++) {
+		if (i % 10 != 0) {
+			scheduler.cancel(ids[i]);
+			cancelled++;
+		}
+	}
+	ret.cancel_ns = timer.start<sw::d_nanoseconds>().count() / cancelled;
+
+	std::size_t checksum{};
+	for (auto now = origin; now <= origin + max_timeout + step; now += step) {
+		ret.expired += scheduler.advance(now, [&](int id) { checksum += static_cast<std::size_t>(id); });
+	}
+	ret.expire_ns = timer.start<sw::d_nanoseconds>().count() / ret.expired;
+
+	bench::do_not_optimize(checksum);
+
+	return ret;
+}
+
+// Adapter so both schedulers have the same interface
+struct wheel_scheduler {
+	sw::timer_wheel<int> wheel;
+
+	wheel_scheduler(clock_type::time_point origin) : wheel(1ms, origin) {
+		wheel.reserve(timer_count);
+	}
+
+	auto schedule_at(clock_type::time_point t, int payload) {
+		return wheel.schedule_at(t, payload);
+	}
+
+	void cancel(sw::timer_wheel<int>::timer_id id) {
+		wheel.cancel(id);
+	}
+
+	template <typename Callback>
+	std::size_t advance(clock_type::time_point now, Callback&& on_expired) {
+		return wheel.advance(now, on_expired);
+	}
+};
+
+struct heap_adapter {
+	heap_scheduler heap;
+
+	int schedule_at(clock_type::time_point t, int) {
+		return heap.schedule_at(t);
+	}
+
+	void cancel(int id) {
+		heap.cancel(id);
+	}
+
+	template <typename Callback>
+	std::size_t advance(clock_type::time_point now, Callback&& on_expired) {
+		return heap.advance(now, on_expired);
+	}
+};
+
+int main() {
+	auto rng		= std::mt19937_64(1);
+	auto origin		= clock_type::now();
+	auto deadlines	= std::vector<clock_type::time_point>();
+
+	deadlines.reserve(timer_count);
+	for (int i{}; i < timer_count; i++) {
+		deadlines.push_back(origin + std::chrono::microseconds(rng() % std::chrono::microseconds(max_timeout).count()));
+	}
+
+	auto wheel	= wheel_scheduler(origin);
+	auto heap	= heap_adapter();
+
+	const auto w = run<wheel_scheduler, sw::timer_wheel<int>::timer_id>(wheel, deadlines, origin);
+	const auto h = run<heap_adapter, int>(heap, deadlines, origin);
+
+	std::printf("%d timers, 90%% cancelled, advancing in %d ms steps over %d s\n\n", timer_count, static_cast<int>(step.count()), static_cast<int>(max_timeout.count()));
+	std::printf("%-24s %16s %16s %16s %12s\n", "", "insert (ns/op)", "cancel (ns/op)", "expire (ns/op)", "expired");
+	std::printf("%-24s %16.1f %16.1f %16.1f %12zu\n", "sw::timer_wheel", w.insert_ns, w.cancel_ns, w.expire_ns, w.expired);
+	std::printf("%-24s %16.1f %16.1f %16.1f %12zu\n", "std::priority_queue", h.insert_ns, h.cancel_ns, h.expire_ns, h.expired);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+// Measures the cost of a span of sw::tracer with different sample rates, compared with just reading the clock. The sink discards the spans.
+
+#include "common.hpp"
+#include "tracing.hpp"
+
+constexpr int iterations	= 1'000'000;
+constexpr int rounds		= 20;
+
+static void bench_rate(const char* name, double rate) {
+	auto tracer = sw::tracer([](const std::vector<sw::span_record>& spans) { bench::do_not_optimize(spans.size()); }, rate);
+
+	bench::print_row(name, bench::run(iterations, rounds, [&] {
+		auto span = tracer.start_span("bench");
+		bench::do_not_optimize(span);
+	}));
+}
+
+int main() {
+	bench::print_header("ns per span");
+
+	bench::print_row("steady_clock::now()", bench::run(iterations, rounds, [] {
+		bench::do_not_optimize(std::chrono::steady_clock::now());
+	}));
+
+	bench_rate("root span, sampled", 1.0);
+	bench_rate("root span, 1% sampled", 0.01);
+	bench_rate("root span, not sampled", 0.0);
+
+	{
+		auto tracer		= sw::tracer([](const std::vector<sw::span_record>&) {});
+		auto parent		= tracer.start_span("parent");
+
+		bench::print_row("child span, sampled", bench::run(iterations, rounds, [&] {
+			auto span = parent.child("bench");
+			bench::do_not_optimize(span);
+		}));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Measures the cost of entering and leaving a section watched by sw::watchdog, compared with just reading the clock, while the watchdog scans in the background.
+
+#include "common.hpp"
+#include "watchdog.hpp"
+
+#include <atomic>
+
+using namespace std::literals::chrono_literals;
+
+constexpr int iterations	= 10'000'000;
+constexpr int rounds		= 20;
+
+int main() {
+	std::atomic<int> reported{};
+	auto wd = sw::watchdog(1ms, [&](const sw::watchdog_event&) { reported++; });
+
+	bench::print_header("ns per section");
+
+	bench::print_row("steady_clock::now()", bench::run(iterations, rounds, [] {
+		bench::do_not_optimize(std::chrono::steady_clock::now());
+	}));
+
+	bench::print_row("watch()", bench::run(iterations, rounds, [&] {
+		auto s = wd.watch("bench", 500ms);
+		bench::do_not_optimize(s);
+	}));
+
+	bench::print_row("watch(), nested twice", bench::run(iterations, rounds, [&] {
+		auto outer = wd.watch("outer", 500ms);
+		auto inner = wd.watch("inner", 500ms);
+		bench::do_not_optimize(inner);
+	}));
+
+	std::printf("\n%d sections reported\n", reported.load());
+}
\ No newline at end of file
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_ASYNC_EXPORTER_HPP_
+#define _A_ASYNC_EXPORTER_HPP_
+
+#include "thread_bindings.hpp"
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sw {
+
+	// What an exporter does when the queue of a thread is full, because the background thread can't keep up.
+	enum class backpressure {
+		drop,		// The new record is dropped. Recording never waits.
+		overwrite,	// The oldest record that wasn't exported yet is overwritten. Recording never waits, and the newest records are kept.
+		block		// Recording waits until the background thread makes room. Nothing is lost, but the recording thread can stall.
+	};
+
+	// A timing record handed to the sink of an exporter.
+	struct exported_record {
+		const char*		name;
+		std::int64_t	start_ns;		// Since the epoch of the clock used for recording
+		std::int64_t	duration_ns;
+		std::uint32_t	thread;			// Index of the recording thread, in the order the threads first recorded
+	};
+
+	// The durations of every record with the same name in a batch.
+	struct export_summary {
+		const char*			name;
+		duration_histogram	durations;
+	};
+
+	// The records an exporter collected since the previous batch.
+	struct export_batch {
+		std::vector<exported_record>	records;	// In the order they were recorded, for each thread
+		std::vector<export_summary>		summaries;	// One per name, in the order the names first appear in the records
+		std::uint64_t					lost{};		// Records dropped or overwritten since the previous batch
+	};
+
+	// Hands timing records from the threads that time things to a background thread, which batches and aggregates them and passes them to a sink. Flushing statistics or writing to a file on a hot thread causes latency spikes there; with this, recording is a few stores into a queue of the calling thread. Each thread has its own single-producer single-consumer ring, so recording threads never contend with each other.
+	template <typename MonotonicTrivialClock>
+	class basic_async_exporter {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using sink_type		= std::function<void(const export_batch&)>;
+
+	private:
+
+		// The sequence number of a slot is its position in the ring plus one once it's written, and 0 while it's being written. The background thread checks it before and after reading the slot, so a slot overwritten meanwhile is noticed.
+		struct slot {
+			std::atomic<std::uint64_t>	seq{};
+			std::atomic<const char*>	name{};
+			std::atomic<std::int64_t>	start{};
+			std::atomic<std::int64_t>	duration{};
+		};
+
+		struct thread_ring {
+			thread_ring(std::size_t capacity, std::uint32_t index) : slots(capacity), thread{ index } {}
+
+			std::vector<slot>	slots;
+			std::uint32_t		thread;
+			std::atomic<bool>	alive{ true };
+
+			// Only written by the recording thread
+			alignas(detail::cache_line_size) std::atomic<std::uint64_t>	head{};
+			std::uint64_t												cached_tail{};
+			std::atomic<std::uint64_t>									dropped{};
+
+			// Only written by the background thread
+			alignas(detail::cache_line_size) std::atomic<std::uint64_t>	tail{};
+			std::uint64_t												reported_dropped{};
+		};
+
+	public:
+
+		// Times a section with a stopwatch, and records it when destroyed.
+		class scope {
+		public:
+			scope(const scope&)				= delete;
+			scope& operator=(const scope&)	= delete;
+
+			~scope() {
+				m_exporter->record(m_name, m_timer);
+			}
+
+			// Returns the stopwatch timing the section. Pausing it leaves the paused time out of the recorded duration.
+			[[nodiscard]] basic_stopwatch<clock>& timer() noexcept {
+				return m_timer;
+			}
+
+		private:
+			friend class basic_async_exporter;
+
+			scope(basic_async_exporter& exporter, const char* name) noexcept : m_exporter{ &exporter }, m_name{ name } {
+				m_timer.start();
+			}
+
+			basic_async_exporter*	m_exporter;
+			const char*				m_name;
+			basic_stopwatch<clock>	m_timer;
+		};
+
+		// Creates an exporter that passes a batch to `sink` every `interval` on a background thread, if anything was recorded. The queue of each thread holds `capacity` records, rounded up to a power of two, and `policy` decides what happens when it's full. With a zero interval, there's no background thread, and flush() has to be called instead. Since nothing would make room for a blocked thread then, a zero interval with backpressure::block throws std::invalid_argument.
+		template <typename Rep, typename Period>
+		basic_async_exporter(std::chrono::duration<Rep, Period> interval, sink_type sink, backpressure policy = backpressure::drop, std::size_t capacity = 4096) :
+			m_sink{ std::move(sink) },
+			m_policy{ policy },
+			m_capacity{ ceil_pow2(std::max<std::size_t>(capacity, 2)) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			if (policy == backpressure::block && interval <= interval.zero()) throw std::invalid_argument("Blocking backpressure needs a background thread");
+
+			if (interval > interval.zero()) {
+				m_thread = std::thread([this, interval = std::chrono::ceil<std::chrono::nanoseconds>(interval)] {
+					std::unique_lock<std::mutex> lock(m_stop_mutex);
+
+					while (!m_stop) {
+						m_cv.wait_for(lock, interval, [&] { return m_stop || m_wake.load(std::memory_order_relaxed); });
+						m_wake.store(false, std::memory_order_relaxed);
+
+						lock.unlock();
+						flush();
+						lock.lock();
+					}
+				});
+			}
+		}
+
+		// Stops the background thread, and exports what's left in the queues.
+		~basic_async_exporter() {
+			{
+				std::lock_guard<std::mutex> lock(m_stop_mutex);
+				m_stop = true;
+			}
+
+			m_cv.notify_all();
+
+			if (m_thread.joinable()) m_thread.join();
+
+			flush();
+		}
+
+		basic_async_exporter(const basic_async_exporter&)				= delete;
+		basic_async_exporter& operator=(const basic_async_exporter&)	= delete;
+
+		// Records a section named `name` that started at `start` and took `d`. `name` must stay valid for the lifetime of the exporter, like a string literal does. The first record on a thread registers the thread, after that it's a few stores, unless the queue is full.
+		template <typename Rep, typename Period>
+		void record(const char* name, time_point start, std::chrono::duration<Rep, Period> d) {
+			push(*this_thread_ring(), name, to_ns(start), std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+		}
+
+		// Records a section named `name` that ends now, and took as long as the elapsed time of the stopwatch.
+		template <typename... Policies>
+		void record(const char* name, const basic_stopwatch<clock, Policies...>& stopwatch) {
+			const auto elapsed = stopwatch.get_elapsed();
+
+			record(name, clock::now() - elapsed, elapsed);
+		}
+
+		// Times a section until the returned scope is destroyed.
+		[[nodiscard]] scope trace(const char* name) noexcept {
+			return scope(*this, name);
+		}
+
+		// Collects the records of every thread into a batch and passes it to the sink, if there's anything to report. This is what the background thread does periodically. Returns the number of records exported.
+		std::size_t flush() {
+			std::lock_guard<std::mutex> flush_lock(m_flush_mutex);
+
+			m_batch.records.clear();
+			m_batch.summaries.clear();
+			m_batch.lost = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+				for (const auto& ring : m_rings) drain(*ring);
+
+				// The rings of threads that exited are dropped once they're drained
+				m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(), [](const auto& r) { return !r->alive.load(std::memory_order_acquire) && r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire); }), m_rings.end());
+			}
+
+			if (m_batch.records.empty() && m_batch.lost == 0) return 0;
+
+			summarize();
+
+			m_exported.store(m_exported.load(std::memory_order_relaxed) + m_batch.records.size(), std::memory_order_relaxed);
+			m_lost.store(m_lost.load(std::memory_order_relaxed) + m_batch.lost, std::memory_order_relaxed);
+
+			m_sink(m_batch);
+
+			return m_batch.records.size();
+		}
+
+		// Returns the number of records passed to the sink so far.
+		[[nodiscard]] std::uint64_t exported() const noexcept {
+			return m_exported.load(std::memory_order_relaxed);
+		}
+
+		// Returns the number of records dropped or overwritten so far, because a queue was full.
+		[[nodiscard]] std::uint64_t lost() const noexcept {
+			return m_lost.load(std::memory_order_relaxed);
+		}
+
+		// Returns the number of records the queue of each thread holds.
+		[[nodiscard]] std::size_t capacity() const noexcept {
+			return m_capacity;
+		}
+
+		// Returns the backpressure policy.
+		[[nodiscard]] backpressure policy() const noexcept {
+			return m_policy;
+		}
+
+	private:
+
+		sink_type									m_sink;
+		backpressure								m_policy;
+		std::size_t									m_capacity;
+
+		std::mutex									m_rings_mutex;
+		std::vector<std::shared_ptr<thread_ring>>	m_rings;
+		std::uint32_t								m_next_thread{};
+
+		std::mutex									m_flush_mutex;
+		export_batch								m_batch;
+		std::unordered_map<std::string_view, std::size_t>	m_summary_index;
+		std::atomic<std::uint64_t>					m_exported{};
+		std::atomic<std::uint64_t>					m_lost{};
+
+		std::mutex									m_stop_mutex;
+		std::condition_variable						m_cv;
+		bool										m_stop{};
+		std::atomic<bool>							m_wake{};
+		std::thread									m_thread;
+
+		// The rings of threads that exited are freed by the flush that drains them
+		detail::thread_bindings<thread_ring>		m_bindings;
+
+		thread_ring* this_thread_ring() {
+			if (auto* ring = m_bindings.find()) return ring;
+
+			std::shared_ptr<thread_ring> ring;
+
+			{
+				std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+				ring = std::make_shared<thread_ring>(m_capacity, m_next_thread++);
+				m_rings.push_back(ring);
+			}
+
+			m_bindings.bind(ring);
+
+			return ring.get();
+		}
+
+		void push(thread_ring& r, const char* name, std::int64_t start_ns, std::int64_t duration_ns) {
+			const auto pos = r.head.load(std::memory_order_relaxed);
+
+			// The tail is only reloaded when the ring looks full, so the cache line of the background thread is rarely touched
+			if (m_policy != backpressure::overwrite && pos - r.cached_tail >= m_capacity) {
+				r.cached_tail = r.tail.load(std::memory_order_acquire);
+
+				while (pos - r.cached_tail >= m_capacity) {
+					if (m_policy == backpressure::drop) {
+						r.dropped.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+
+					// Set under the lock, so the wake-up isn't lost if the background thread is about to wait
+					if (!m_wake.load(std::memory_order_relaxed)) {
+						{
+							std::lock_guard<std::mutex> lock(m_stop_mutex);
+							m_wake.store(true, std::memory_order_relaxed);
+						}
+
+						m_cv.notify_one();
+					}
+
+					std::this_thread::yield();
+
+					r.cached_tail = r.tail.load(std::memory_order_acquire);
+				}
+			}
+
+			auto& s = r.slots[pos & (m_capacity - 1)];
+
+			s.seq.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			s.name.store(name, std::memory_order_relaxed);
+			s.start.store(start_ns, std::memory_order_relaxed);
+			s.duration.store(duration_ns, std::memory_order_relaxed);
+
+			s.seq.store(pos + 1, std::memory_order_release);
+			r.head.store(pos + 1, std::memory_order_release);
+		}
+
+		void drain(thread_ring& r) {
+			const auto head	= r.head.load(std::memory_order_acquire);
+			auto tail		= r.tail.load(std::memory_order_relaxed);
+
+			// Only happens when overwriting; the oldest records are gone
+			if (head - tail > m_capacity) {
+				m_batch.lost	+= head - m_capacity - tail;
+				tail			= head - m_capacity;
+			}
+
+			for (; tail != head; tail++) {
+				auto& s = r.slots[tail & (m_capacity - 1)];
+
+				const auto seq = s.seq.load(std::memory_order_acquire);
+
+				if (seq != tail + 1) {
+					m_batch.lost++;
+					continue;
+				}
+
+				const auto name		= s.name.load(std::memory_order_relaxed);
+				const auto start	= s.start.load(std::memory_order_relaxed);
+				const auto duration	= s.duration.load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				// Overwritten while reading it
+				if (s.seq.load(std::memory_order_relaxed) != seq) {
+					m_batch.lost++;
+					continue;
+				}
+
+				m_batch.records.push_back({ name, start, duration, r.thread });
+			}
+
+			r.tail.store(head, std::memory_order_release);
+
+			const auto dropped = r.dropped.load(std::memory_order_relaxed);
+
+			m_batch.lost			+= dropped - r.reported_dropped;
+			r.reported_dropped		= dropped;
+		}
+
+		void summarize() {
+			m_summary_index.clear();
+
+			for (const auto& r : m_batch.records) {
+				const auto [it, inserted] = m_summary_index.try_emplace(r.name, m_batch.summaries.size());
+
+				if (inserted) m_batch.summaries.push_back({ r.name, duration_histogram() });
+
+				m_batch.summaries[it->second].durations.record(std::chrono::nanoseconds(r.duration_ns));
+			}
+		}
+
+		static constexpr std::size_t ceil_pow2(std::size_t v) noexcept {
+			std::size_t ret = 1;
+			while (ret < v) ret <<= 1;
+			return ret;
+		}
+
+		static std::int64_t to_ns(const time_point& t) noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+		}
+	};
+
+	// Asynchronous exporter using std::chrono::steady_clock.
+	using async_exporter = basic_async_exporter<std::chrono::steady_clock>;
+
+	// Returns a sink for an exporter that writes batches to a file, such as one opened with std::fopen(), or a pipe opened with popen(). Each record is a line of "name<TAB>thread<TAB>start ns<TAB>duration ns". Lost records are reported on a line of "# lost<TAB>count". The file is flushed after each batch, and it must stay open for the lifetime of the exporter.
+	inline std::function<void(const export_batch&)> file_export_sink(std::FILE* file) {
+		return [file](const export_batch& batch) {
+			for (const auto& r : batch.records) {
+				std::fprintf(file, "%s\t%u\t%lld\t%lld\n", r.name, static_cast<unsigned>(r.thread), static_cast<long long>(r.start_ns), static_cast<long long>(r.duration_ns));
+			}
+
+			if (batch.lost > 0) std::fprintf(file, "# lost\t%llu\n", static_cast<unsigned long long>(batch.lost));
+
+			std::fflush(file);
+		};
+	}
+}
+
+#endif
\ No newline at end of file
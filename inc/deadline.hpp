@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_DEADLINE_HPP_
+#define _A_DEADLINE_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sw {
+
+	// A time budget for loops that need to stop after a given amount of time. expired() only reads the clock every N calls, and N is tuned on the fly from the observed time between calls, so that expired() notices the deadline within `tolerance` of it passing.
+	template <typename MonotonicTrivialClock>
+	class basic_deadline {
+	public:
+		using clock		= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using duration	= typename clock::duration;
+
+		// The largest number of calls between two clock reads.
+		static constexpr std::uint32_t max_interval = 1u << 20;
+
+		// Starts a deadline that expires after `budget`. `tolerance` is how late expired() may notice that.
+		template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+		basic_deadline(std::chrono::duration<Rep1, Period1> budget, std::chrono::duration<Rep2, Period2> tolerance) noexcept {
+			reset(budget, tolerance);
+		}
+
+		// Starts a deadline that expires after `budget`, with a tolerance of 1% of the budget.
+		template <typename Rep, typename Period>
+		explicit basic_deadline(std::chrono::duration<Rep, Period> budget) noexcept :
+			basic_deadline(budget, std::chrono::duration_cast<duration>(budget) / 100)
+		{}
+
+		// Restarts the deadline with a new budget and tolerance.
+		template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+		void reset(std::chrono::duration<Rep1, Period1> budget, std::chrono::duration<Rep2, Period2> tolerance) noexcept {
+			m_budget		= std::chrono::duration_cast<duration>(budget);
+			m_tolerance		= std::max(convert_time<d_nanoseconds>(tolerance).count(), 1.0);
+			m_cost			= 0.0;
+			m_interval		= 1;
+			m_countdown		= 1;
+			m_last_check	= duration::zero();
+			m_expired		= m_budget <= duration::zero();
+
+			m_timer.reset();
+			m_timer.start();
+		}
+
+		// Indicates if the deadline has passed. Meant to be called once per iteration of a loop. It only reads the clock every check_interval() calls.
+		[[nodiscard]] bool expired() noexcept {
+			if (m_expired) return true;
+			if (--m_countdown != 0) return false;
+
+			return check();
+		}
+
+		// Indicates if the deadline has passed, always reading the clock. This doesn't affect the tuning of expired().
+		[[nodiscard]] bool expired_now() const noexcept {
+			return m_expired || m_timer.get_elapsed() >= m_budget;
+		}
+
+		// Returns the time left until the deadline, or zero if it has passed. Useful for passing a budget on to a sub-call.
+		[[nodiscard]] duration remaining() const noexcept {
+			return std::max(m_budget - m_timer.get_elapsed(), duration::zero());
+		}
+
+		// Returns the time elapsed since the deadline was started.
+		[[nodiscard]] duration get_elapsed() const noexcept {
+			return m_timer.get_elapsed();
+		}
+
+		// Returns the total budget.
+		[[nodiscard]] duration budget() const noexcept {
+			return m_budget;
+		}
+
+		// Returns the current number of expired() calls between two clock reads.
+		[[nodiscard]] std::uint32_t check_interval() const noexcept {
+			return m_interval;
+		}
+
+	private:
+
+		basic_stopwatch<clock>	m_timer;
+		duration				m_budget{};
+		duration				m_last_check{};
+		double					m_tolerance{};	// Nanoseconds
+		double					m_cost{};		// Nanoseconds per call
+		std::uint32_t			m_interval{ 1 };
+		std::uint32_t			m_countdown{ 1 };
+		bool					m_expired{};
+
+		bool check() noexcept {
+			const auto elapsed = m_timer.get_elapsed();
+
+			if (elapsed >= m_budget) {
+				m_expired = true;
+				return true;
+			}
+
+			const auto cost = convert_time<d_nanoseconds>(elapsed - m_last_check).count() / m_interval;
+
+			// Slowdowns are taken into account right away, speedups only gradually
+			m_cost			= cost > m_cost ? cost : 0.75 * m_cost + 0.25 * cost;
+			m_last_check	= elapsed;
+
+			// The interval is only allowed to double at a time in case the cost estimate is off
+			const auto target = m_cost > 0.0 ? m_tolerance / m_cost : static_cast<double>(max_interval);
+
+			m_interval	= static_cast<std::uint32_t>(std::clamp(target, 1.0, std::min(2.0 * m_interval, static_cast<double>(max_interval))));
+			m_countdown	= m_interval;
+
+			return false;
+		}
+	};
+
+	// Deadline using std::chrono::steady_clock.
+	using deadline = basic_deadline<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_FIXED_TIMESTEP_HPP_
+#define _A_FIXED_TIMESTEP_HPP_
+
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sw {
+
+	// Fixed-timestep stepper for simulation and game loops. Each frame, the time since the previous frame is added to an accumulator, and as many fixed-length updates are run as fit in it. The leftover is exposed as an interpolation factor for rendering.
+	template <typename MonotonicTrivialClock>
+	class basic_fixed_timestep {
+	public:
+		using clock		= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using duration	= typename clock::duration;
+
+		// Creates a stepper with the given update length. At most `max_steps` updates are run per frame; if a frame takes longer than that, the excess time is dropped, so that a slow frame can't cause an ever growing backlog of updates.
+		template <typename Rep, typename Period>
+		explicit basic_fixed_timestep(std::chrono::duration<Rep, Period> step, std::uint32_t max_steps = 8) noexcept :
+			m_step{ std::max(std::chrono::ceil<duration>(step), duration{ 1 }) },
+			m_max_steps{ std::max(max_steps, 1u) }
+		{}
+
+		// Starts a new frame, and returns the number of updates to run in it. The first call only starts the clock and returns 0.
+		std::uint32_t advance() noexcept {
+			const bool first	= m_timer.is_paused();
+			const auto lap		= m_timer.start();
+
+			if (first) return 0;
+
+			m_frame_times.record(lap);
+			m_accumulator += lap;
+
+			auto steps = static_cast<std::uint64_t>(m_accumulator / m_step);
+
+			if (steps > m_max_steps) {
+				const auto excess = static_cast<typename duration::rep>(steps - m_max_steps) * m_step;
+
+				m_dropped		+= excess;
+				m_accumulator	-= excess;
+				steps			= m_max_steps;
+			}
+
+			m_accumulator	-= static_cast<typename duration::rep>(steps) * m_step;
+			m_total_steps	+= steps;
+
+			return static_cast<std::uint32_t>(steps);
+		}
+
+		// Starts a new frame, and calls `update(step())` for each update to run in it. Returns the number of updates.
+		template <typename Update>
+		std::uint32_t frame(Update&& update) {
+			const auto steps = advance();
+
+			for (std::uint32_t i{}; i < steps; i++) update(m_step);
+
+			return steps;
+		}
+
+		// Returns how far the simulation is between the last update and the next one, in the range [0, 1). Rendering can interpolate between the last two states using this.
+		[[nodiscard]] double alpha() const noexcept {
+			return convert_time<d_nanoseconds>(m_accumulator) / convert_time<d_nanoseconds>(m_step);
+		}
+
+		// Returns the length of an update.
+		[[nodiscard]] duration step() const noexcept {
+			return m_step;
+		}
+
+		// Returns the time that's accumulated but not yet covered by an update.
+		[[nodiscard]] duration accumulated() const noexcept {
+			return m_accumulator;
+		}
+
+		// Returns the total time dropped because of the `max_steps` limit.
+		[[nodiscard]] duration dropped() const noexcept {
+			return m_dropped;
+		}
+
+		// Returns the total number of updates so far.
+		[[nodiscard]] std::uint64_t total_steps() const noexcept {
+			return m_total_steps;
+		}
+
+		// Returns the statistics of the frame times.
+		[[nodiscard]] const duration_accumulator& frame_times() const noexcept {
+			return m_frame_times;
+		}
+
+		// Puts the stepper back in its initial state. The next advance() starts the clock again.
+		void reset() noexcept {
+			m_timer.reset();
+			m_frame_times.reset();
+			m_accumulator	= duration::zero();
+			m_dropped		= duration::zero();
+			m_total_steps	= 0;
+		}
+
+	private:
+
+		basic_stopwatch<clock>	m_timer;
+		duration				m_step;
+		duration				m_accumulator{};
+		duration				m_dropped{};
+		std::uint64_t			m_total_steps{};
+		std::uint32_t			m_max_steps;
+		duration_accumulator	m_frame_times;
+	};
+
+	// Fixed-timestep stepper using std::chrono::steady_clock.
+	using fixed_timestep = basic_fixed_timestep<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_FLIGHT_RECORDER_HPP_
+#define _A_FLIGHT_RECORDER_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sw {
+
+	// A timing event read back from a flight recorder file.
+	struct flight_event {
+		std::string		name;
+		std::int64_t	start_ns{};		// Since the epoch of the clock used for recording
+		std::int64_t	duration_ns{};
+		std::uint64_t	thread{};		// Hash of the id of the recording thread
+		std::uint64_t	sequence{};		// Order in which the events were recorded
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		inline constexpr char			flight_magic[8]		= { 'S', 'W', 'F', 'L', 'I', 'G', 'H', 'T' };
+		inline constexpr std::uint32_t	flight_version		= 1;
+		inline constexpr std::size_t	flight_name_size	= 32;
+
+		// The file starts with this header, followed by the ring of records. Every field has a fixed size, so the file can be read on any platform with the same endianness.
+		struct flight_header {
+			char						magic[8];
+			std::uint32_t				version;
+			std::uint32_t				record_size;
+			std::uint64_t				capacity;
+			std::atomic<std::uint64_t>	head;				// Number of records reserved so far
+			std::int64_t				clock_anchor_ns;	// Time of the recording clock when the file was created...
+			std::int64_t				system_anchor_ns;	// ...and the time of std::chrono::system_clock at the same moment
+			std::uint8_t				reserved[16];
+		};
+
+		// A record is valid if its sequence number matches its slot. It's 0 while the record is being written, so a record torn by the death of the process is skipped.
+		struct flight_record {
+			std::atomic<std::uint64_t>	sequence;			// Index of the record plus one
+			std::int64_t				start_ns;
+			std::int64_t				duration_ns;
+			std::uint64_t				thread;
+			char						name[flight_name_size];
+		};
+
+		static_assert(sizeof(flight_header) == 64, "Unexpected flight recorder header layout");
+		static_assert(sizeof(flight_record) == 64, "Unexpected flight recorder record layout");
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The flight recorder needs lock-free 64-bit atomics");
+
+		inline std::uint64_t flight_thread_id() noexcept {
+			thread_local const auto id = static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			return id;
+		}
+
+		// A read-write shared mapping of a whole file, which is created or truncated to the given size
+		class file_mapping {
+		public:
+			file_mapping(const std::string& path, std::size_t size) : m_size{ size } {
+#ifdef _WIN32
+				m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (m_file == INVALID_HANDLE_VALUE) throw_last_error("Can't create " + path);
+
+				m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), nullptr);
+				if (!m_mapping) {
+					CloseHandle(m_file);
+					throw_last_error("Can't map " + path);
+				}
+
+				m_data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+				if (!m_data) {
+					CloseHandle(m_mapping);
+					CloseHandle(m_file);
+					throw_last_error("Can't map " + path);
+				}
+#else
+				const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+				if (fd < 0) throw_last_error("Can't create " + path);
+
+				if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+					::close(fd);
+					throw_last_error("Can't resize " + path);
+				}
+
+				m_data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				::close(fd);
+
+				if (m_data == MAP_FAILED) {
+					m_data = nullptr;
+					throw_last_error("Can't map " + path);
+				}
+#endif
+			}
+
+			~file_mapping() {
+#ifdef _WIN32
+				UnmapViewOfFile(m_data);
+				CloseHandle(m_mapping);
+				CloseHandle(m_file);
+#else
+				::munmap(m_data, m_size);
+#endif
+			}
+
+			file_mapping(const file_mapping&)				= delete;
+			file_mapping& operator=(const file_mapping&)	= delete;
+
+			void* data() const noexcept {
+				return m_data;
+			}
+
+		private:
+			void*		m_data{};
+			std::size_t	m_size;
+#ifdef _WIN32
+			HANDLE		m_file{};
+			HANDLE		m_mapping{};
+#endif
+
+			[[noreturn]] static void throw_last_error(const std::string& what) {
+#ifdef _WIN32
+				throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+				throw std::system_error(errno, std::generic_category(), what);
+#endif
+			}
+		};
+
+	}
+
+	// Records timing events into a ring of fixed-size records in a memory-mapped file. The file is shared with the OS page cache, so the last events survive the death of the process, and can be decoded with read_flight_recording() or tools/flight_reader afterwards. Recording an event reserves a record with a single atomic increment, and never blocks.
+	template <typename MonotonicTrivialClock>
+	class basic_flight_recorder {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+
+		// Times a section with a stopwatch, and records it when destroyed.
+		class scope {
+		public:
+			scope(const scope&)				= delete;
+			scope& operator=(const scope&)	= delete;
+
+			~scope() {
+				m_recorder->record(m_name, m_timer);
+			}
+
+			// Returns the stopwatch timing the section. Pausing it leaves the paused time out of the recorded duration.
+			[[nodiscard]] basic_stopwatch<clock>& timer() noexcept {
+				return m_timer;
+			}
+
+		private:
+			friend class basic_flight_recorder;
+
+			scope(basic_flight_recorder& recorder, const char* name) noexcept : m_recorder{ &recorder }, m_name{ name } {
+				m_timer.start();
+			}
+
+			basic_flight_recorder*	m_recorder;
+			const char*				m_name;
+			basic_stopwatch<clock>	m_timer;
+		};
+
+		// Creates the file at `path`, or overwrites it, with room for the last `capacity` events. Each event takes 64 bytes. Throws std::system_error if the file can't be created.
+		basic_flight_recorder(const std::string& path, std::size_t capacity) :
+			m_capacity{ std::max<std::size_t>(capacity, 1) },
+			m_file{ path, sizeof(detail::flight_header) + m_capacity * sizeof(detail::flight_record) },
+			m_header{ static_cast<detail::flight_header*>(m_file.data()) },
+			m_records{ reinterpret_cast<detail::flight_record*>(m_header + 1) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			std::memcpy(m_header->magic, detail::flight_magic, sizeof(m_header->magic));
+			m_header->version			= detail::flight_version;
+			m_header->record_size		= sizeof(detail::flight_record);
+			m_header->capacity			= m_capacity;
+			m_header->clock_anchor_ns	= to_ns(clock::now());
+			m_header->system_anchor_ns	= std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			m_header->head.store(0, std::memory_order_release);
+		}
+
+		basic_flight_recorder(const basic_flight_recorder&)				= delete;
+		basic_flight_recorder& operator=(const basic_flight_recorder&)	= delete;
+
+		// Records an event that started at `start` and took `d`. Names longer than 31 characters are cut off. The event is dropped if the ring wrapped around to its record while another thread was still writing it, or already wrote a newer one there.
+		template <typename Rep, typename Period>
+		void record(const char* name, time_point start, std::chrono::duration<Rep, Period> d) noexcept {
+			const auto index	= m_header->head.fetch_add(1, std::memory_order_relaxed);
+			auto& r				= m_records[index % m_capacity];
+
+			// The record is claimed by taking its sequence number from an older, finished record to 0, so only one thread writes it at a time. A 0 is also an untouched record, which only the first round of the ring may take.
+			auto previous = r.sequence.load(std::memory_order_relaxed);
+
+			if ((previous == 0 && index >= m_capacity) || previous > index) return;
+			if (!r.sequence.compare_exchange_strong(previous, 0, std::memory_order_relaxed)) return;
+
+			std::atomic_thread_fence(std::memory_order_release);
+
+			r.start_ns		= to_ns(start);
+			r.duration_ns	= std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+			r.thread		= detail::flight_thread_id();
+
+			std::size_t i{};
+			for (; i < detail::flight_name_size - 1 && name[i]; i++) r.name[i] = name[i];
+			std::memset(r.name + i, 0, detail::flight_name_size - i);
+
+			r.sequence.store(index + 1, std::memory_order_release);
+		}
+
+		// Records an event named `name` that ends now, and took as long as the elapsed time of the stopwatch.
+		template <typename... Policies>
+		void record(const char* name, const basic_stopwatch<clock, Policies...>& stopwatch) noexcept {
+			const auto elapsed = stopwatch.get_elapsed();
+
+			record(name, clock::now() - elapsed, elapsed);
+		}
+
+		// Times a section until the returned scope is destroyed. `name` must stay valid until then.
+		[[nodiscard]] scope trace(const char* name) noexcept {
+			return scope(*this, name);
+		}
+
+		// Returns the number of events the ring can hold.
+		[[nodiscard]] std::size_t capacity() const noexcept {
+			return m_capacity;
+		}
+
+		// Returns the number of events recorded so far, including the ones overwritten or dropped since.
+		[[nodiscard]] std::uint64_t recorded() const noexcept {
+			return m_header->head.load(std::memory_order_relaxed);
+		}
+
+	private:
+
+		std::size_t					m_capacity;
+		detail::file_mapping		m_file;
+		detail::flight_header*		m_header;
+		detail::flight_record*		m_records;
+
+		static std::int64_t to_ns(time_point t) noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+		}
+	};
+
+	// Flight recorder using std::chrono::steady_clock.
+	using flight_recorder = basic_flight_recorder<std::chrono::steady_clock>;
+
+	// The contents of a flight recorder file.
+	struct flight_recording {
+		std::vector<flight_event>	events;				// Sorted by start time
+		std::uint64_t				recorded{};			// Number of events recorded, including the ones overwritten
+		std::int64_t				clock_anchor_ns{};	// Time of the recording clock when the file was created...
+		std::int64_t				system_anchor_ns{};	// ...and the time of std::chrono::system_clock at the same moment
+
+		// Converts a time of the recording clock to nanoseconds since the epoch of std::chrono::system_clock.
+		[[nodiscard]] std::int64_t to_system_ns(std::int64_t clock_ns) const noexcept {
+			return clock_ns - clock_anchor_ns + system_anchor_ns;
+		}
+	};
+
+	// Reads a flight recorder file, even while it's being written or after the recording process died. Records torn by the death of the process are skipped. Throws std::runtime_error if the file can't be read or isn't a flight recorder file.
+	inline flight_recording read_flight_recording(const std::string& path) {
+		auto file = std::ifstream(path, std::ios::binary);
+		auto data = std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		if (!file && !file.eof()) throw std::runtime_error("Can't read " + path);
+
+		const auto header_size = sizeof(detail::flight_header);
+
+		// The fields are read one by one, since the file isn't necessarily aligned in memory
+		const auto read = [&](std::size_t offset, auto& value) {
+			std::memcpy(&value, data.data() + offset, sizeof(value));
+		};
+
+		std::uint32_t version{}, record_size{};
+		std::uint64_t capacity{}, head{};
+		auto ret = flight_recording();
+
+		if (data.size() < header_size || std::memcmp(data.data(), detail::flight_magic, sizeof(detail::flight_magic)) != 0) throw std::runtime_error(path + " is not a flight recorder file");
+
+		read(offsetof(detail::flight_header, version), version);
+		read(offsetof(detail::flight_header, record_size), record_size);
+		read(offsetof(detail::flight_header, capacity), capacity);
+		read(offsetof(detail::flight_header, head), head);
+		read(offsetof(detail::flight_header, clock_anchor_ns), ret.clock_anchor_ns);
+		read(offsetof(detail::flight_header, system_anchor_ns), ret.system_anchor_ns);
+
+		// The capacity comes from the file, so it's checked against the size without multiplying, which could overflow
+		if (version != detail::flight_version || record_size != sizeof(detail::flight_record) || capacity > (data.size() - header_size) / record_size) throw std::runtime_error(path + " has an unsupported format or is truncated");
+
+		ret.recorded = head;
+
+		for (std::uint64_t i{}; i < capacity; i++) {
+			const auto offset = header_size + i * record_size;
+
+			std::uint64_t sequence{};
+			read(offset + offsetof(detail::flight_record, sequence), sequence);
+
+			if (sequence == 0 || (sequence - 1) % capacity != i) continue;
+
+			char name[detail::flight_name_size + 1]{};
+			auto e = flight_event();
+
+			read(offset + offsetof(detail::flight_record, start_ns), e.start_ns);
+			read(offset + offsetof(detail::flight_record, duration_ns), e.duration_ns);
+			read(offset + offsetof(detail::flight_record, thread), e.thread);
+			std::memcpy(name, data.data() + offset + offsetof(detail::flight_record, name), detail::flight_name_size);
+
+			e.name		= name;
+			e.sequence	= sequence - 1;
+
+			ret.events.push_back(std::move(e));
+		}
+
+		std::sort(ret.events.begin(), ret.events.end(), [](const auto& a, const auto& b) { return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.sequence < b.sequence; });
+
+		return ret;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_HICCUP_METER_HPP_
+#define _A_HICCUP_METER_HPP_
+
+#include "ticker.hpp"
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sw {
+
+	// Detects stalls of the whole process, such as page faults, memory compaction or scheduling delays, that application-level timing can't attribute. A thread repeatedly waits for a short interval, and records how much longer than that it actually took (the "hiccup") into a histogram. The histogram is reported periodically, so stalls can be correlated with request latency over time.
+	template <typename MonotonicTrivialClock, typename WaitStrategy = sleep_wait>
+	class basic_hiccup_meter {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+
+		// The hiccups of a reporting interval.
+		struct interval_report {
+			time_point			begin;
+			time_point			end;
+			duration_histogram	hiccups;
+		};
+
+		using callback_type = std::function<void(const interval_report&)>;
+
+		// Creates a meter that waits for `resolution` at a time, and reports to `callback` every `report_interval`. The meter doesn't run until start() is called.
+		template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+		basic_hiccup_meter(std::chrono::duration<Rep1, Period1> resolution, std::chrono::duration<Rep2, Period2> report_interval, callback_type callback, WaitStrategy wait = WaitStrategy{}) :
+			m_resolution{ std::max(std::chrono::ceil<duration>(resolution), duration{ 1 }) },
+			m_report_interval{ std::chrono::ceil<duration>(report_interval) },
+			m_callback{ std::move(callback) },
+			m_wait{ std::move(wait) },
+			m_interval_begin{ clock::now() }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+		}
+
+		// Stops the meter.
+		~basic_hiccup_meter() {
+			stop();
+		}
+
+		basic_hiccup_meter(const basic_hiccup_meter&)				= delete;
+		basic_hiccup_meter& operator=(const basic_hiccup_meter&)	= delete;
+
+		// Starts measuring on a background thread. Does nothing if it's already running.
+		void start() {
+			if (m_thread.joinable()) return;
+
+			m_stop = false;
+			m_thread = std::thread([this] {
+				while (!m_stop.load(std::memory_order_relaxed)) {
+					sample();
+
+					if (clock::now() - interval_begin() >= m_report_interval) report();
+				}
+			});
+		}
+
+		// Stops the background thread. The current interval is not reported.
+		void stop() {
+			m_stop = true;
+
+			if (m_thread.joinable()) m_thread.join();
+		}
+
+		// Waits for `resolution` once, and records the hiccup. Returns the hiccup. This is what the background thread does repeatedly; it can also be called directly, without start().
+		duration sample() {
+			auto timer = basic_stopwatch<clock>();
+
+			timer.start();
+			m_wait(clock::now() + m_resolution);
+
+			const auto hiccup = std::max(timer.get_elapsed() - m_resolution, duration::zero());
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			record(hiccup);
+
+			return hiccup;
+		}
+
+		// Ends the current interval, passes its report to the callback, and returns it.
+		interval_report report() {
+			auto ret = interval_report();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				ret.begin			= m_interval_begin;
+				ret.end				= clock::now();
+				ret.hiccups			= m_interval;
+				m_interval_begin	= ret.end;
+				m_interval.reset();
+			}
+
+			if (m_callback) m_callback(ret);
+
+			return ret;
+		}
+
+		// Returns the hiccups of every interval so far, including the current one.
+		[[nodiscard]] duration_histogram totals() const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_totals;
+		}
+
+		// Returns how long the meter waits at a time.
+		[[nodiscard]] duration resolution() const noexcept {
+			return m_resolution;
+		}
+
+	private:
+
+		duration					m_resolution;
+		duration					m_report_interval;
+		callback_type				m_callback;
+		WaitStrategy				m_wait;
+
+		mutable std::mutex			m_mutex;
+		time_point					m_interval_begin;
+		duration_histogram			m_interval;
+		duration_histogram			m_totals;
+
+		std::atomic<bool>			m_stop{};
+		std::thread					m_thread;
+
+		// A stall also delays the samples that would have been taken during it. Those are recorded too, as if they had been taken, so that the histogram isn't skewed towards short hiccups (this corrects for "coordinated omission").
+		void record(duration hiccup) noexcept {
+			m_interval.record(hiccup);
+			m_totals.record(hiccup);
+
+			for (auto missed = hiccup - m_resolution; missed >= m_resolution; missed -= m_resolution) {
+				m_interval.record(missed);
+				m_totals.record(missed);
+			}
+		}
+
+		time_point interval_begin() const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_interval_begin;
+		}
+	};
+
+	// Hiccup meter using std::chrono::steady_clock.
+	using hiccup_meter = basic_hiccup_meter<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
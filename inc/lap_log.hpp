@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_LAP_LOG_HPP_
+#define _A_LAP_LOG_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sw {
+
+	// A lap as stored in a lap log: the time it ended, and its duration, both in nanoseconds.
+	struct lap_record {
+		std::int64_t timestamp_ns{};
+		std::int64_t duration_ns{};
+
+		friend constexpr bool operator==(const lap_record& a, const lap_record& b) noexcept {
+			return a.timestamp_ns == b.timestamp_ns && a.duration_ns == b.duration_ns;
+		}
+
+		friend constexpr bool operator!=(const lap_record& a, const lap_record& b) noexcept {
+			return !(a == b);
+		}
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Each block starts with the number of laps in it as a 32-bit little-endian integer, followed by a bit stream
+		inline constexpr std::size_t lap_block_header_size = 4;
+
+		// Prefix codes of the delta-of-delta of timestamps, as in Gorilla: a 0 bit for no change, otherwise a run of 1 bits selecting the size of the value that follows
+		struct dod_bucket {
+			int				prefix_bits;
+			std::uint64_t	prefix;
+			int				value_bits;
+		};
+
+		inline constexpr dod_bucket dod_buckets[] = {
+			{ 2, 0b10,		7 },
+			{ 3, 0b110,		12 },
+			{ 4, 0b1110,	20 },
+			{ 5, 0b11110,	32 },
+			{ 5, 0b11111,	64 }
+		};
+
+		constexpr std::uint64_t zigzag_encode(std::int64_t v) noexcept {
+			return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+		}
+
+		constexpr std::int64_t zigzag_decode(std::uint64_t v) noexcept {
+			return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+		}
+
+		constexpr bool fits_signed(std::int64_t v, int bits) noexcept {
+			return bits >= 64 || (v >= -(std::int64_t{ 1 } << (bits - 1)) && v < (std::int64_t{ 1 } << (bits - 1)));
+		}
+
+		// Number of bits a delta-of-delta takes
+		constexpr int dod_size(std::int64_t dod) noexcept {
+			if (dod == 0) return 1;
+
+			for (const auto& b : dod_buckets) {
+				if (fits_signed(dod, b.value_bits)) return b.prefix_bits + b.value_bits;
+			}
+
+			return 0;
+		}
+
+		// Number of bits a varint takes, 8 for each group of 7 bits
+		constexpr int varint_size(std::uint64_t v) noexcept {
+			int groups = 1;
+
+			while (v >>= 7) groups++;
+
+			return groups * 8;
+		}
+
+		// Writes bits into a buffer, most significant bit first. The buffer must be zeroed.
+		class bit_writer {
+		public:
+			bit_writer(std::uint8_t* data, std::size_t bit_pos) noexcept : m_data{ data }, m_pos{ bit_pos } {}
+
+			void write(std::uint64_t value, int bits) noexcept {
+				while (bits > 0) {
+					const int free		= 8 - static_cast<int>(m_pos % 8);
+					const int take		= std::min(free, bits);
+					const auto chunk	= (value >> (bits - take)) & ((1u << take) - 1);
+
+					m_data[m_pos / 8] |= static_cast<std::uint8_t>(chunk << (free - take));
+					m_pos += static_cast<std::size_t>(take);
+					bits -= take;
+				}
+			}
+
+			void write_dod(std::int64_t dod) noexcept {
+				if (dod == 0) {
+					write(0, 1);
+					return;
+				}
+
+				for (const auto& b : dod_buckets) {
+					if (fits_signed(dod, b.value_bits)) {
+						write(b.prefix, b.prefix_bits);
+						write(static_cast<std::uint64_t>(dod), b.value_bits);
+						return;
+					}
+				}
+			}
+
+			void write_varint(std::uint64_t v) noexcept {
+				while (v >= 0x80) {
+					write((v & 0x7f) | 0x80, 8);
+					v >>= 7;
+				}
+
+				write(v, 8);
+			}
+
+			std::size_t position() const noexcept {
+				return m_pos;
+			}
+
+		private:
+			std::uint8_t*	m_data;
+			std::size_t		m_pos;
+		};
+
+		// Reads up to `end_pos` bits. Reading past it, or a malformed value, fails the reader, after which every read returns zero.
+		class bit_reader {
+		public:
+			bit_reader(const std::uint8_t* data, std::size_t bit_pos, std::size_t end_pos) noexcept : m_data{ data }, m_pos{ bit_pos }, m_end{ end_pos } {}
+
+			std::uint64_t read(int bits) noexcept {
+				std::uint64_t ret{};
+
+				if (m_failed || m_end - m_pos < static_cast<std::size_t>(bits)) {
+					m_failed = true;
+					return 0;
+				}
+
+				while (bits > 0) {
+					const int avail	= 8 - static_cast<int>(m_pos % 8);
+					const int take	= std::min(avail, bits);
+					const auto byte	= static_cast<std::uint64_t>(m_data[m_pos / 8]);
+
+					ret = (ret << take) | ((byte >> (avail - take)) & ((1u << take) - 1));
+					m_pos += static_cast<std::size_t>(take);
+					bits -= take;
+				}
+
+				return ret;
+			}
+
+			std::int64_t read_dod() noexcept {
+				if (read(1) == 0) return 0;
+
+				int ones = 1;
+
+				while (ones < 5 && read(1) == 1) ones++;
+
+				const auto& b = dod_buckets[ones - 1];
+				const auto raw = read(b.value_bits);
+
+				// Sign extension
+				if (b.value_bits == 64) return static_cast<std::int64_t>(raw);
+
+				const auto shift = 64 - b.value_bits;
+
+				return static_cast<std::int64_t>(raw << shift) >> shift;
+			}
+
+			// A 64-bit value takes at most 10 groups of 7 bits
+			std::uint64_t read_varint() noexcept {
+				std::uint64_t ret{};
+
+				for (int shift{}; shift < 70; shift += 7) {
+					const auto group = read(8);
+
+					ret |= (group & 0x7f) << shift;
+
+					if ((group & 0x80) == 0) return ret;
+				}
+
+				m_failed = true;
+				return 0;
+			}
+
+			std::size_t position() const noexcept {
+				return m_pos;
+			}
+
+			bool failed() const noexcept {
+				return m_failed;
+			}
+
+		private:
+			const std::uint8_t*	m_data;
+			std::size_t			m_pos;
+			std::size_t			m_end;
+			bool				m_failed{};
+		};
+
+		inline std::uint32_t read_block_count(const std::uint8_t* block) noexcept {
+			return static_cast<std::uint32_t>(block[0]) | static_cast<std::uint32_t>(block[1]) << 8 | static_cast<std::uint32_t>(block[2]) << 16 | static_cast<std::uint32_t>(block[3]) << 24;
+		}
+
+		inline void write_block_count(std::uint8_t* block, std::uint32_t count) noexcept {
+			for (int i{}; i < 4; i++) block[i] = static_cast<std::uint8_t>(count >> (8 * i));
+		}
+
+	}
+
+	// Append-only log of laps, compressed into fixed-size blocks. Timestamps are stored as the delta of their deltas, using the prefix codes of Gorilla; durations as the zig-zag varint of the change from the previous one. Regular laps take a few bytes each instead of 16. Every block can be decoded on its own, so the log can be read from any block, and the blocks can be written to a file as they fill up.
+	class lap_log {
+	public:
+
+		// Creates an empty log with blocks of the given size in bytes. Blocks are at least 64 bytes.
+		explicit lap_log(std::size_t block_size = 4096) :
+			m_block_size{ std::max<std::size_t>(block_size, 64) }
+		{}
+
+		// Adds a lap that ended at `timestamp_ns`, and took `duration_ns`.
+		void append(std::int64_t timestamp_ns, std::int64_t duration_ns) {
+			const auto delta	= timestamp_ns - m_last.timestamp_ns;
+			const auto dod		= delta - m_last_delta;
+			const auto dur		= detail::zigzag_encode(duration_ns - m_last.duration_ns);
+
+			if (m_block_count == 0 || m_bit_pos + static_cast<std::size_t>(detail::dod_size(dod) + detail::varint_size(dur)) > m_block_size * 8) {
+				start_block();
+				append(timestamp_ns, duration_ns);
+				return;
+			}
+
+			auto w				= detail::bit_writer(current_block(), m_bit_pos);
+			const auto first	= m_bit_pos == detail::lap_block_header_size * 8;
+
+			w.write_dod(dod);
+			w.write_varint(dur);
+
+			m_bit_pos		= w.position();
+			m_last			= { timestamp_ns, duration_ns };
+			m_last_delta	= first ? 0 : delta;
+			m_count++;
+
+			detail::write_block_count(current_block(), detail::read_block_count(current_block()) + 1);
+		}
+
+		// Adds a lap that ended at `timestamp`, and took `duration`.
+		template <typename Clock, typename Duration, typename Rep, typename Period>
+		void append(const std::chrono::time_point<Clock, Duration>& timestamp, std::chrono::duration<Rep, Period> duration) {
+			append(std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count(), std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+		}
+
+		// Restarts the stopwatch, and adds the returned lap with the time it ended, which is read from the clock once for both. Returns the lap.
+		template <typename MonotonicTrivialClock, typename... Policies>
+		auto lap(basic_stopwatch<MonotonicTrivialClock, Policies...>& stopwatch) {
+			const auto now	= MonotonicTrivialClock::now();
+			const auto d	= stopwatch.start(now);
+
+			append(now, d);
+
+			return d;
+		}
+
+		// Removes every lap.
+		void clear() noexcept {
+			m_data.clear();
+			m_block_count	= 0;
+			m_bit_pos		= 0;
+			m_count			= 0;
+		}
+
+		// Returns the number of laps.
+		[[nodiscard]] std::size_t size() const noexcept {
+			return m_count;
+		}
+
+		// Returns the number of blocks, including the one being filled.
+		[[nodiscard]] std::size_t block_count() const noexcept {
+			return m_block_count;
+		}
+
+		// Returns the size of a block in bytes.
+		[[nodiscard]] std::size_t block_size() const noexcept {
+			return m_block_size;
+		}
+
+		// Returns a block. Every block but the last one is complete.
+		[[nodiscard]] const std::uint8_t* block(std::size_t index) const noexcept {
+			return m_data.data() + index * m_block_size;
+		}
+
+		// Returns the blocks, which are block_count() * block_size() bytes.
+		[[nodiscard]] const std::uint8_t* data() const noexcept {
+			return m_data.data();
+		}
+
+		// Returns the number of bytes the laps take, not counting the unused end of the last block.
+		[[nodiscard]] std::size_t used_bytes() const noexcept {
+			return m_block_count ? (m_block_count - 1) * m_block_size + (m_bit_pos + 7) / 8 : 0;
+		}
+
+	private:
+
+		std::size_t					m_block_size;
+		std::vector<std::uint8_t>	m_data;
+		std::size_t					m_block_count{};
+		std::size_t					m_bit_pos{};
+		std::size_t					m_count{};
+		lap_record					m_last;
+		std::int64_t				m_last_delta{};
+
+		std::uint8_t* current_block() noexcept {
+			return m_data.data() + (m_block_count - 1) * m_block_size;
+		}
+
+		// A block starts from zero, so the first lap in it is stored in full. Its delta is the whole timestamp, so the next lap is stored against a delta of 0 instead, which keeps it small.
+		void start_block() {
+			m_data.resize((m_block_count + 1) * m_block_size);
+			m_block_count++;
+			m_bit_pos		= detail::lap_block_header_size * 8;
+			m_last			= {};
+			m_last_delta	= 0;
+		}
+	};
+
+	// Decodes the blocks of a lap_log in order, starting from any block. The data can come from a lap_log, or from a file it was written to. Reading stops at the first malformed block, so truncated or corrupt data ends the laps early, but is never read past.
+	class lap_log_reader {
+	public:
+
+		// Reads `size` bytes of blocks of `block_size` bytes. The data must outlive the reader. Blocks too small to hold their header, such as those of size 0, read as no blocks.
+		lap_log_reader(const std::uint8_t* data, std::size_t size, std::size_t block_size) noexcept :
+			m_data{ data },
+			m_block_size{ block_size },
+			m_block_count{ block_size > detail::lap_block_header_size ? size / block_size : 0 }
+		{
+			seek_block(0);
+		}
+
+		// Reads the blocks of a lap log. The log must not change while it's being read.
+		explicit lap_log_reader(const lap_log& log) noexcept :
+			lap_log_reader(log.data(), log.block_count() * log.block_size(), log.block_size())
+		{}
+
+		// Reads the next lap into `lap`. Returns false if there are no more, or the block holding it is malformed.
+		bool next(lap_record& lap) noexcept {
+			while (m_remaining == 0) {
+				if (m_block + 1 >= m_block_count) return false;
+				seek_block(m_block + 1);
+			}
+
+			auto r				= detail::bit_reader(m_data + m_block * m_block_size, m_bit_pos, m_block_size * 8);
+			const auto first	= m_bit_pos == detail::lap_block_header_size * 8;
+
+			const auto delta	= m_last_delta + r.read_dod();
+			const auto duration	= detail::zigzag_decode(r.read_varint());
+
+			if (r.failed()) {
+				m_block			= m_block_count;
+				m_remaining		= 0;
+				return false;
+			}
+
+			m_last.timestamp_ns	+= delta;
+			m_last.duration_ns	+= duration;
+			m_last_delta		= first ? 0 : delta;
+			m_bit_pos			= r.position();
+			m_remaining--;
+
+			lap = m_last;
+			return true;
+		}
+
+		// Continues reading from the start of a block.
+		void seek_block(std::size_t index) noexcept {
+			m_block			= index;
+			m_remaining		= index < m_block_count ? detail::read_block_count(m_data + index * m_block_size) : 0;
+			m_bit_pos		= detail::lap_block_header_size * 8;
+			m_last			= {};
+			m_last_delta	= 0;
+		}
+
+		// Returns the number of blocks.
+		[[nodiscard]] std::size_t block_count() const noexcept {
+			return m_block_count;
+		}
+
+		// Returns the number of laps in a block.
+		[[nodiscard]] std::size_t block_laps(std::size_t index) const noexcept {
+			return detail::read_block_count(m_data + index * m_block_size);
+		}
+
+	private:
+		const std::uint8_t*	m_data;
+		std::size_t			m_block_size;
+		std::size_t			m_block_count;
+		std::size_t			m_block{};
+		std::size_t			m_remaining{};
+		std::size_t			m_bit_pos{};
+		lap_record			m_last;
+		std::int64_t		m_last_delta{};
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_LOCK_PROFILER_HPP_
+#define _A_LOCK_PROFILER_HPP_
+
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sw {
+
+	// How much a timed_mutex_wrapper measures.
+	enum class lock_timing {
+		full,		// Every acquisition is timed, both the wait and the hold time.
+		sampling	// Uncontended acquisitions are only counted, without reading the clock. Only contended ones are timed.
+	};
+
+	// Contention statistics of a lock, as returned by contention_report().
+	struct lock_contention_stats {
+		std::string			name;
+		std::uint64_t		acquisitions{};
+		std::uint64_t		contended{};
+		duration_histogram	wait;	// Time spent waiting to acquire the lock
+		duration_histogram	hold;	// Time the lock was held for
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		struct lock_stats_slot {
+			std::mutex				mutex;
+			lock_contention_stats	stats;
+		};
+
+		// Every lock with the same name shares a slot. Slots are never freed, so the statistics of a lock stay in the report after the lock is destroyed.
+		class lock_registry {
+		public:
+			lock_stats_slot* get(const std::string& name) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto& slot = m_slots[name];
+
+				if (!slot) {
+					slot = std::make_unique<lock_stats_slot>();
+					slot->stats.name = name;
+				}
+
+				return slot.get();
+			}
+
+			template <typename Callback>
+			void for_each(Callback&& callback) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				for (auto& slot : m_slots) callback(*slot.second);
+			}
+
+			static lock_registry& instance() {
+				static lock_registry registry;
+				return registry;
+			}
+
+		private:
+			std::mutex												m_mutex;
+			std::map<std::string, std::unique_ptr<lock_stats_slot>>	m_slots;
+		};
+
+		// Samples are buffered per thread, and only merged into the per-lock statistics when the buffer fills up, when the thread exits, or on request.
+		class lock_sample_buffer {
+		public:
+			static constexpr std::int64_t no_time = -1;
+
+			lock_sample_buffer() {
+				// Makes sure the registry outlives the buffer of every thread
+				lock_registry::instance();
+			}
+
+			~lock_sample_buffer() {
+				flush();
+			}
+
+			void add(lock_stats_slot* slot, std::int64_t wait_ns, std::int64_t hold_ns, bool contended) {
+				m_samples[m_size++] = { slot, wait_ns, hold_ns, contended };
+
+				if (m_size == m_samples.size()) flush();
+			}
+
+			void flush() {
+				// Samples of the same lock tend to come in runs, so the slot is only relocked when it changes
+				lock_stats_slot* current{};
+				std::unique_lock<std::mutex> lock;
+
+				for (std::size_t i{}; i < m_size; i++) {
+					const auto& s = m_samples[i];
+
+					if (s.slot != current) {
+						current	= s.slot;
+						lock	= std::unique_lock<std::mutex>(current->mutex);
+					}
+
+					auto& stats = current->stats;
+
+					stats.acquisitions++;
+					if (s.contended) stats.contended++;
+					if (s.wait_ns != no_time) stats.wait.record(std::chrono::nanoseconds(s.wait_ns));
+					if (s.hold_ns != no_time) stats.hold.record(std::chrono::nanoseconds(s.hold_ns));
+				}
+
+				m_size = 0;
+			}
+
+			static lock_sample_buffer& this_thread() {
+				thread_local lock_sample_buffer buffer;
+				return buffer;
+			}
+
+		private:
+			struct sample {
+				lock_stats_slot*	slot;
+				std::int64_t		wait_ns;
+				std::int64_t		hold_ns;
+				bool				contended;
+			};
+
+			std::array<sample, 256>	m_samples{};
+			std::size_t				m_size{};
+		};
+
+	}
+
+	// Wraps a mutex to measure how long threads wait to acquire it and how long they hold it. It meets the same Lockable requirements as the wrapped mutex, so it works with std::lock_guard and the like. Locks with the same name share their statistics.
+	template <typename Mutex = std::mutex, typename MonotonicTrivialClock = std::chrono::steady_clock>
+	class timed_mutex_wrapper {
+	public:
+		using mutex_type	= Mutex;
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+
+		// Creates a lock with the given name and timing mode.
+		explicit timed_mutex_wrapper(const std::string& name, lock_timing timing = lock_timing::full) :
+			m_slot{ detail::lock_registry::instance().get(name) },
+			m_timing{ timing }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+		}
+
+		timed_mutex_wrapper(const timed_mutex_wrapper&)				= delete;
+		timed_mutex_wrapper& operator=(const timed_mutex_wrapper&)	= delete;
+
+		// Acquires the lock, blocking if needed.
+		void lock() {
+			if (m_mutex.try_lock()) {
+				on_uncontended();
+				return;
+			}
+
+			const auto wait_start = clock::now();
+			m_mutex.lock();
+			m_hold_start = clock::now();
+			m_timed = true;
+
+			m_wait_ns	= std::chrono::duration_cast<std::chrono::nanoseconds>(m_hold_start - wait_start).count();
+			m_contended	= true;
+		}
+
+		// Tries to acquire the lock without blocking. A failed attempt doesn't count as contention.
+		bool try_lock() {
+			if (!m_mutex.try_lock()) return false;
+
+			on_uncontended();
+			return true;
+		}
+
+		// Releases the lock. The sample of this acquisition is recorded here, after the lock is released.
+		void unlock() {
+			const auto hold_ns		= m_timed ? std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_hold_start).count() : detail::lock_sample_buffer::no_time;
+			const auto wait_ns		= m_wait_ns;
+			const auto contended	= m_contended;
+
+			m_mutex.unlock();
+
+			detail::lock_sample_buffer::this_thread().add(m_slot, wait_ns, hold_ns, contended);
+		}
+
+		// Returns the wrapped mutex.
+		[[nodiscard]] Mutex& native() noexcept {
+			return m_mutex;
+		}
+
+		// Returns the name of the lock.
+		[[nodiscard]] const std::string& name() const noexcept {
+			return m_slot->stats.name;
+		}
+
+	private:
+
+		Mutex							m_mutex;
+		detail::lock_stats_slot*		m_slot;
+		lock_timing						m_timing;
+
+		// Only accessed by the thread holding the lock
+		typename clock::time_point		m_hold_start{};
+		std::int64_t					m_wait_ns{};
+		bool							m_timed{};
+		bool							m_contended{};
+
+		void on_uncontended() {
+			m_contended	= false;
+			m_timed		= m_timing == lock_timing::full;
+			m_wait_ns	= m_timed ? 0 : detail::lock_sample_buffer::no_time;
+
+			if (m_timed) m_hold_start = clock::now();
+		}
+	};
+
+	// Merges the buffered lock samples of the calling thread into the statistics. Buffers are also flushed automatically when they fill up and when their thread exits.
+	inline void flush_lock_stats() {
+		detail::lock_sample_buffer::this_thread().flush();
+	}
+
+	// Returns the statistics of every lock, ranked by the total time spent waiting for them. The samples of the calling thread are flushed first; samples still buffered by other threads are not included.
+	inline std::vector<lock_contention_stats> contention_report() {
+		flush_lock_stats();
+
+		auto ret = std::vector<lock_contention_stats>();
+
+		detail::lock_registry::instance().for_each([&](detail::lock_stats_slot& slot) {
+			std::lock_guard<std::mutex> lock(slot.mutex);
+			ret.push_back(slot.stats);
+		});
+
+		std::stable_sort(ret.begin(), ret.end(), [](const auto& a, const auto& b) { return a.wait.sum() > b.wait.sum(); });
+
+		return ret;
+	}
+
+	// Clears the statistics of every lock. The samples of the calling thread are dropped too; samples still buffered by other threads will show up later.
+	inline void reset_lock_stats() {
+		flush_lock_stats();
+
+		detail::lock_registry::instance().for_each([](detail::lock_stats_slot& slot) {
+			std::lock_guard<std::mutex> lock(slot.mutex);
+
+			slot.stats.acquisitions	= 0;
+			slot.stats.contended	= 0;
+			slot.stats.wait.reset();
+			slot.stats.hold.reset();
+		});
+	}
+
+	// Writes contention_report() as a table.
+	inline void write_contention_report(std::ostream& out) {
+		char line[256];
+
+		std::snprintf(line, sizeof(line), "%-32s %12s %10s %14s %12s %12s %12s %12s\n", "lock", "acquired", "contended", "total wait ms", "wait p50 us", "wait p99 us", "wait max us", "hold p99 us");
+		out << line;
+
+		for (const auto& s : contention_report()) {
+			const auto us = [](std::chrono::nanoseconds d) { return convert_time<d_microseconds>(d).count(); };
+
+			std::snprintf(line, sizeof(line), "%-32.32s %12llu %10llu %14.3f %12.3f %12.3f %12.3f %12.3f\n",
+				s.name.c_str(),
+				static_cast<unsigned long long>(s.acquisitions),
+				static_cast<unsigned long long>(s.contended),
+				convert_time<d_milliseconds>(s.wait.sum()).count(),
+				us(s.wait.quantile(0.5)),
+				us(s.wait.quantile(0.99)),
+				us(s.wait.max()),
+				us(s.hold.quantile(0.99)));
+			out << line;
+		}
+	}
+}
+
+#endif
\ No newline at end of file
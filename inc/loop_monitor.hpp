@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_LOOP_MONITOR_HPP_
+#define _A_LOOP_MONITOR_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace sw {
+
+	// Monitors a single-threaded event loop. The loop reports when it starts and stops waiting for events, and when timer callbacks run; from that, the monitor computes the fraction of time the loop is busy (its utilization) over a rolling window, and how late callbacks run (the loop lag). The results can be read from any thread with a few atomic loads, such as for admission control.
+	template <typename MonotonicTrivialClock>
+	class basic_loop_monitor {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+
+		// Creates a monitor that measures utilization over windows of the given length, and reports it over the last `windows` of them. The loop is considered busy from here on until the first idle_begin().
+		template <typename Rep, typename Period>
+		explicit basic_loop_monitor(std::chrono::duration<Rep, Period> window, std::size_t windows = 1) :
+			m_window{ std::max(std::chrono::ceil<duration>(window), duration{ 1 }) },
+			m_history(std::max<std::size_t>(windows, 1))
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			m_busy.start();
+			m_window_start = clock::now();
+			m_busy_since.store(to_ns(m_window_start), std::memory_order_relaxed);
+		}
+
+		basic_loop_monitor(const basic_loop_monitor&)				= delete;
+		basic_loop_monitor& operator=(const basic_loop_monitor&)	= delete;
+
+		// Call this right before the loop starts waiting for events.
+		void idle_begin() noexcept {
+			m_busy.pause();
+			m_busy_since.store(0, std::memory_order_relaxed);
+			roll(clock::now());
+		}
+
+		// Call this right after the loop is done waiting for events.
+		void idle_end() noexcept {
+			m_busy.start();
+
+			const auto now = clock::now();
+
+			m_busy_since.store(to_ns(now), std::memory_order_relaxed);
+			roll(now);
+		}
+
+		// Calls `wait()` between idle_begin() and idle_end(), and returns its result.
+		template <typename Wait>
+		decltype(auto) idle(Wait&& wait) {
+			struct guard {
+				basic_loop_monitor& monitor;
+				~guard() { monitor.idle_end(); }
+			};
+
+			idle_begin();
+			const guard g{ *this };
+
+			return std::forward<Wait>(wait)();
+		}
+
+		// Call this when a callback scheduled for `scheduled` starts running. Records how late it is.
+		template <typename Duration>
+		void record_lag(const std::chrono::time_point<clock, Duration>& scheduled) noexcept {
+			const auto lag = std::max<std::int64_t>(to_ns(clock::now()) - to_ns(scheduled), 0);
+
+			m_last_lag.store(lag, std::memory_order_relaxed);
+
+			if (lag > m_window_max_lag.load(std::memory_order_relaxed)) m_window_max_lag.store(lag, std::memory_order_relaxed);
+		}
+
+		// Returns the fraction of time the loop was busy over the last completed windows, from 0 to 1. It's 0 until the first window is completed.
+		[[nodiscard]] double utilization() const noexcept {
+			return m_utilization.load(std::memory_order_relaxed);
+		}
+
+		// Returns the lag of the last callback.
+		[[nodiscard]] std::chrono::nanoseconds last_lag() const noexcept {
+			return std::chrono::nanoseconds{ m_last_lag.load(std::memory_order_relaxed) };
+		}
+
+		// Returns the largest lag in the last completed window and the current one.
+		[[nodiscard]] std::chrono::nanoseconds max_lag() const noexcept {
+			return std::chrono::nanoseconds{ std::max(m_max_lag.load(std::memory_order_relaxed), m_window_max_lag.load(std::memory_order_relaxed)) };
+		}
+
+		// Returns how long the loop has been busy since it last stopped waiting, or zero if it's waiting now. Unlike utilization(), this keeps growing while the loop is stuck.
+		[[nodiscard]] std::chrono::nanoseconds busy_time() const noexcept {
+			const auto since = m_busy_since.load(std::memory_order_relaxed);
+
+			return std::chrono::nanoseconds{ since ? std::max<std::int64_t>(to_ns(clock::now()) - since, 0) : 0 };
+		}
+
+		// Returns the length of a window.
+		[[nodiscard]] duration window() const noexcept {
+			return m_window;
+		}
+
+	private:
+
+		struct window_totals {
+			duration busy{};
+			duration wall{};
+		};
+
+		duration					m_window;
+		basic_stopwatch<clock>		m_busy;
+		time_point					m_window_start{};
+
+		// Ring of the last completed windows, and their totals
+		std::vector<window_totals>	m_history;
+		std::size_t					m_next{};
+		window_totals				m_totals;
+
+		// Read by other threads
+		std::atomic<double>			m_utilization{};
+		std::atomic<std::int64_t>	m_last_lag{};
+		std::atomic<std::int64_t>	m_max_lag{};
+		std::atomic<std::int64_t>	m_window_max_lag{};
+		std::atomic<std::int64_t>	m_busy_since{};
+
+		// Completes the current window if it's over
+		void roll(time_point now) noexcept {
+			const auto wall = now - m_window_start;
+
+			if (wall < m_window) return;
+
+			const auto busy = std::min(m_busy.get_elapsed(), wall);
+
+			auto& slot = m_history[m_next];
+			m_next = (m_next + 1) % m_history.size();
+
+			m_totals.busy += busy - slot.busy;
+			m_totals.wall += wall - slot.wall;
+			slot = { busy, wall };
+
+			m_utilization.store(convert_time<d_nanoseconds>(m_totals.busy) / convert_time<d_nanoseconds>(m_totals.wall), std::memory_order_relaxed);
+			m_max_lag.store(m_window_max_lag.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+
+			// The busy time of the next window starts from zero, in the same state
+			if (m_busy.is_paused()) m_busy.reset();
+			else m_busy.start();
+
+			m_window_start = now;
+		}
+
+		template <typename Duration>
+		static std::int64_t to_ns(const std::chrono::time_point<clock, Duration>& t) noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+		}
+	};
+
+	// Event loop monitor using std::chrono::steady_clock.
+	using loop_monitor = basic_loop_monitor<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
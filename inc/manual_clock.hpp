@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_MANUAL_CLOCK_HPP_
+#define _A_MANUAL_CLOCK_HPP_
+
+#include "stopwatch.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace sw {
+
+	// A monotonic clock that only moves when it's told to, which makes timing deterministic in tests and simulations. Each distinct `Tag` type gives a separate clock with its own time.
+	template <typename Tag = void>
+	struct basic_manual_clock {
+		using rep			= std::int64_t;
+		using period		= std::nano;
+		using duration		= std::chrono::duration<rep, period>;
+		using time_point	= std::chrono::time_point<basic_manual_clock, duration>;
+
+		static constexpr bool is_steady = true;
+
+		// The time the clock starts from. It's not zero because basic_stopwatch treats the zero time point as "no value".
+		static constexpr time_point epoch{ std::chrono::hours(1) };
+
+		// Returns the current time of the clock.
+		static time_point now() noexcept {
+			return time_point{ duration{ s_now.load() } };
+		}
+
+		// Moves the clock forward. Negative durations are ignored, since the clock is monotonic.
+		template <typename Rep, typename Period>
+		static void advance(std::chrono::duration<Rep, Period> d) noexcept {
+			const auto ticks = std::chrono::ceil<duration>(d).count();
+
+			if (ticks > 0) s_now.fetch_add(ticks);
+		}
+
+		// Moves the clock forward to the given time point. If the clock is already past it, nothing happens, since the clock is monotonic.
+		static void set(time_point t) noexcept {
+			auto current = s_now.load();
+
+			while (current < t.time_since_epoch().count() && !s_now.compare_exchange_weak(current, t.time_since_epoch().count())) {}
+		}
+
+		// Puts the clock back to `epoch`. This is the only way to move it backwards, so only do it when nothing is measuring time with it (between two tests for example).
+		static void reset() noexcept {
+			s_now.store(epoch.time_since_epoch().count());
+		}
+
+	private:
+
+		static inline std::atomic<rep> s_now{ epoch.time_since_epoch().count() };
+	};
+
+	// A manually advanced clock. Use basic_manual_clock with your own tag type if you need several independent ones.
+	using manual_clock = basic_manual_clock<>;
+}
+
+#endif
\ No newline at end of file
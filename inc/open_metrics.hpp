@@ -0,0 +1,569 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_OPEN_METRICS_HPP_
+#define _A_OPEN_METRICS_HPP_
+
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Metric names have to match [a-zA-Z_:][a-zA-Z0-9_:]*
+		inline bool is_metric_name(const std::string& name) noexcept {
+			if (name.empty() || (name[0] >= '0' && name[0] <= '9')) return false;
+
+			return std::all_of(name.begin(), name.end(), [](char c) {
+				return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+			});
+		}
+
+		// Writes a duration in seconds, exactly and without trailing zeros, such as 0.005 for 5 ms
+		inline void write_seconds(std::ostream& out, std::int64_t ns) {
+			char buffer[32];
+
+			const auto whole	= static_cast<long long>(ns / 1'000'000'000);
+			auto fraction		= static_cast<long long>(ns % 1'000'000'000);
+
+			if (fraction == 0) {
+				std::snprintf(buffer, sizeof(buffer), "%lld", whole);
+			} else {
+				auto digits = 9;
+				while (fraction % 10 == 0) {
+					fraction /= 10;
+					digits--;
+				}
+
+				std::snprintf(buffer, sizeof(buffer), "%lld.%0*lld", whole, digits, fraction);
+			}
+
+			out << buffer;
+		}
+
+		// Escapes the text of a HELP line
+		inline void write_help(std::ostream& out, const std::string& name, const std::string& help) {
+			if (help.empty()) return;
+
+			out << "# HELP " << name << ' ';
+
+			for (const char c : help) {
+				if (c == '\\')		out << "\\\\";
+				else if (c == '\n')	out << "\\n";
+				else if (c == '"')	out << "\\\"";
+				else				out << c;
+			}
+
+			out << '\n';
+		}
+
+		// A unit is only declared for names that end with it, as OpenMetrics requires
+		inline void write_metadata(std::ostream& out, const std::string& name, const char* type, const std::string& help) {
+			constexpr std::string_view unit = "_seconds";
+
+			out << "# TYPE " << name << ' ' << type << '\n';
+
+			if (name.size() > unit.size() && name.compare(name.size() - unit.size(), unit.size(), unit) == 0) out << "# UNIT " << name << " seconds\n";
+
+			write_help(out, name, help);
+		}
+
+		// Atomic totals shared by every metric kind. Recording only does relaxed atomic operations, so rendering never blocks it.
+		class atomic_totals {
+		public:
+			void add(std::int64_t ns) noexcept {
+				m_count.fetch_add(1, std::memory_order_relaxed);
+				m_sum.fetch_add(static_cast<std::uint64_t>(ns), std::memory_order_relaxed);
+			}
+
+			std::uint64_t count() const noexcept {
+				return m_count.load(std::memory_order_relaxed);
+			}
+
+			std::int64_t sum() const noexcept {
+				return static_cast<std::int64_t>(m_sum.load(std::memory_order_relaxed));
+			}
+
+		private:
+			std::atomic<std::uint64_t>	m_count{};
+			std::atomic<std::uint64_t>	m_sum{};	// In nanoseconds
+		};
+
+		template <typename Rep, typename Period>
+		std::int64_t to_metric_ns(std::chrono::duration<Rep, Period> d) noexcept {
+			return std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(), 0);
+		}
+
+	}
+
+	// Base of the metrics of an open_metrics_registry. Every metric measures durations, fed directly or from a stopwatch.
+	class timer_metric {
+	public:
+		virtual ~timer_metric() = default;
+
+		timer_metric(const timer_metric&)				= delete;
+		timer_metric& operator=(const timer_metric&)	= delete;
+
+		// Returns the name of the metric.
+		[[nodiscard]] const std::string& name() const noexcept {
+			return m_name;
+		}
+
+		// Writes the metric in the OpenMetrics text format.
+		virtual void render(std::ostream& out) const = 0;
+
+	protected:
+		timer_metric(std::string name, std::string help) : m_name{ std::move(name) }, m_help{ std::move(help) } {}
+
+		std::string m_name;
+		std::string m_help;
+	};
+
+	// Counts the time spent in something, rendered as an OpenMetrics counter of seconds.
+	class timer_counter final : public timer_metric {
+	public:
+		timer_counter(std::string name, std::string help) : timer_metric(std::move(name), std::move(help)) {}
+
+		// Adds a duration to the counter. Negative durations count as 0.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d) noexcept {
+			m_totals.add(detail::to_metric_ns(d));
+		}
+
+		// Adds the elapsed time of a stopwatch to the counter.
+		template <typename Clock, typename... Policies>
+		void record(const basic_stopwatch<Clock, Policies...>& stopwatch) noexcept {
+			record(stopwatch.get_elapsed());
+		}
+
+		// Returns the number of recorded durations.
+		[[nodiscard]] std::uint64_t count() const noexcept {
+			return m_totals.count();
+		}
+
+		// Returns the sum of the recorded durations.
+		[[nodiscard]] std::chrono::nanoseconds sum() const noexcept {
+			return std::chrono::nanoseconds(m_totals.sum());
+		}
+
+		void render(std::ostream& out) const override {
+			detail::write_metadata(out, m_name, "counter", m_help);
+
+			out << m_name << "_total ";
+			detail::write_seconds(out, m_totals.sum());
+			out << '\n';
+		}
+
+	private:
+		detail::atomic_totals m_totals;
+	};
+
+	// Records durations into a log-linear histogram like duration_histogram, rendered as an OpenMetrics summary with the given quantiles. The quantiles cover every duration recorded since the creation of the summary.
+	class timer_summary final : public timer_metric {
+	public:
+		timer_summary(std::string name, std::string help, std::vector<double> quantiles) :
+			timer_metric(std::move(name), std::move(help)),
+			m_quantiles{ std::move(quantiles) }
+		{
+			for (const auto q : m_quantiles) {
+				if (!(q >= 0.0 && q <= 1.0)) throw std::invalid_argument("Quantiles must be between 0 and 1");
+			}
+		}
+
+		// Adds a duration to the summary. Negative durations count as 0.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d) noexcept {
+			const auto ns = detail::to_metric_ns(d);
+
+			m_buckets[duration_histogram::bucket_index(static_cast<std::uint64_t>(ns))].fetch_add(1, std::memory_order_relaxed);
+			m_totals.add(ns);
+
+			// Most durations are no new extreme, so these rarely write
+			auto min = m_min.load(std::memory_order_relaxed);
+			while (ns < min && !m_min.compare_exchange_weak(min, ns, std::memory_order_relaxed)) {}
+
+			auto max = m_max.load(std::memory_order_relaxed);
+			while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+		}
+
+		// Adds the elapsed time of a stopwatch to the summary.
+		template <typename Clock, typename... Policies>
+		void record(const basic_stopwatch<Clock, Policies...>& stopwatch) noexcept {
+			record(stopwatch.get_elapsed());
+		}
+
+		// Returns the number of recorded durations.
+		[[nodiscard]] std::uint64_t count() const noexcept {
+			return m_totals.count();
+		}
+
+		// Returns an estimate of the duration at quantile `q` (0 to 1), the same way as duration_histogram::quantile().
+		[[nodiscard]] std::chrono::nanoseconds quantile(double q) const noexcept {
+			auto counts = std::array<std::uint64_t, duration_histogram::bucket_count>();
+			return quantile(q, counts, snapshot(counts));
+		}
+
+		void render(std::ostream& out) const override {
+			auto counts			= std::array<std::uint64_t, duration_histogram::bucket_count>();
+			const auto total	= snapshot(counts);
+
+			detail::write_metadata(out, m_name, "summary", m_help);
+
+			for (const auto q : m_quantiles) {
+				char label[32];
+				std::snprintf(label, sizeof(label), "%g", q);
+
+				out << m_name << "{quantile=\"" << label << "\"} ";
+				detail::write_seconds(out, quantile(q, counts, total).count());
+				out << '\n';
+			}
+
+			out << m_name << "_count " << total << '\n';
+			out << m_name << "_sum ";
+			detail::write_seconds(out, m_totals.sum());
+			out << '\n';
+		}
+
+	private:
+		std::array<std::atomic<std::uint64_t>, duration_histogram::bucket_count>	m_buckets{};
+		detail::atomic_totals														m_totals;
+		std::atomic<std::int64_t>													m_min{ std::numeric_limits<std::int64_t>::max() };
+		std::atomic<std::int64_t>													m_max{};
+		std::vector<double>															m_quantiles;
+
+		// Copies the buckets, and returns their total. It's used as the count, so the count always matches the buckets.
+		std::uint64_t snapshot(std::array<std::uint64_t, duration_histogram::bucket_count>& counts) const noexcept {
+			std::uint64_t total{};
+
+			for (std::size_t i{}; i < counts.size(); i++) {
+				counts[i]	= m_buckets[i].load(std::memory_order_relaxed);
+				total		+= counts[i];
+			}
+
+			return total;
+		}
+
+		std::chrono::nanoseconds quantile(double q, const std::array<std::uint64_t, duration_histogram::bucket_count>& counts, std::uint64_t total) const noexcept {
+			if (total == 0) return std::chrono::nanoseconds::zero();
+
+			const auto min	= m_min.load(std::memory_order_relaxed);
+			const auto max	= std::max(m_max.load(std::memory_order_relaxed), min);
+			const auto rank	= static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total)));
+
+			// The extremes are known exactly
+			if (rank <= 1) return std::chrono::nanoseconds(min);
+			if (rank >= total) return std::chrono::nanoseconds(max);
+
+			std::uint64_t seen{};
+
+			for (std::size_t i{}; i < counts.size(); i++) {
+				seen += counts[i];
+
+				if (seen >= rank) {
+					const auto lower	= duration_histogram::bucket_lower_bound(i);
+					const auto mid		= lower + (duration_histogram::bucket_upper_bound(i) - lower) / 2;
+
+					return std::chrono::nanoseconds(std::clamp<std::int64_t>(static_cast<std::int64_t>(mid), min, max));
+				}
+			}
+
+			return std::chrono::nanoseconds(max);
+		}
+	};
+
+	// Counts durations in buckets with the given upper bounds, rendered as an OpenMetrics histogram.
+	class timer_histogram final : public timer_metric {
+	public:
+		timer_histogram(std::string name, std::string help, std::vector<std::chrono::nanoseconds> bounds) :
+			timer_metric(std::move(name), std::move(help)),
+			m_bounds{ std::move(bounds) },
+			m_buckets{ std::make_unique<std::atomic<std::uint64_t>[]>(m_bounds.size() + 1) }
+		{
+			if (!std::is_sorted(m_bounds.begin(), m_bounds.end()) || std::adjacent_find(m_bounds.begin(), m_bounds.end()) != m_bounds.end()) {
+				throw std::invalid_argument("Bucket bounds must be increasing");
+			}
+		}
+
+		// Adds a duration to the bucket with the lowest bound it doesn't exceed. Negative durations count as 0.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d) noexcept {
+			const auto ns		= detail::to_metric_ns(d);
+			const auto bucket	= std::lower_bound(m_bounds.begin(), m_bounds.end(), std::chrono::nanoseconds(ns)) - m_bounds.begin();
+
+			m_buckets[static_cast<std::size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+			m_totals.add(ns);
+		}
+
+		// Adds the elapsed time of a stopwatch to the histogram.
+		template <typename Clock, typename... Policies>
+		void record(const basic_stopwatch<Clock, Policies...>& stopwatch) noexcept {
+			record(stopwatch.get_elapsed());
+		}
+
+		// Returns the number of recorded durations.
+		[[nodiscard]] std::uint64_t count() const noexcept {
+			return m_totals.count();
+		}
+
+		// Returns the upper bounds of the buckets, without the last one, which has no bound.
+		[[nodiscard]] const std::vector<std::chrono::nanoseconds>& bounds() const noexcept {
+			return m_bounds;
+		}
+
+		void render(std::ostream& out) const override {
+			detail::write_metadata(out, m_name, "histogram", m_help);
+
+			// The buckets are cumulative, and the count is their total, so they always agree
+			std::uint64_t total{};
+
+			for (std::size_t i{}; i <= m_bounds.size(); i++) {
+				total += m_buckets[i].load(std::memory_order_relaxed);
+
+				out << m_name << "_bucket{le=\"";
+
+				if (i < m_bounds.size()) detail::write_seconds(out, m_bounds[i].count());
+				else out << "+Inf";
+
+				out << "\"} " << total << '\n';
+			}
+
+			out << m_name << "_count " << total << '\n';
+			out << m_name << "_sum ";
+			detail::write_seconds(out, m_totals.sum());
+			out << '\n';
+		}
+
+	private:
+		std::vector<std::chrono::nanoseconds>			m_bounds;
+		std::unique_ptr<std::atomic<std::uint64_t>[]>	m_buckets;	// One more than the bounds, for the durations above the last one
+		detail::atomic_totals							m_totals;
+	};
+
+	// Named timing metrics that can be rendered in the OpenMetrics text format, which Prometheus and most monitoring systems scrape. Recording into a metric only does relaxed atomic operations, so rendering never blocks the recording threads; it only blocks the creation of new metrics.
+	class open_metrics_registry {
+	public:
+
+		// The bucket bounds Prometheus clients use by default.
+		static inline const std::vector<std::chrono::nanoseconds> default_bounds = {
+			std::chrono::milliseconds(5), std::chrono::milliseconds(10), std::chrono::milliseconds(25), std::chrono::milliseconds(50),
+			std::chrono::milliseconds(100), std::chrono::milliseconds(250), std::chrono::milliseconds(500),
+			std::chrono::seconds(1), std::chrono::milliseconds(2500), std::chrono::seconds(5), std::chrono::seconds(10)
+		};
+
+		// Returns the counter named `name`, and creates it if it doesn't exist yet. Throws std::invalid_argument if the name isn't a valid metric name, or it's taken by another kind of metric.
+		timer_counter& counter(const std::string& name, const std::string& help = {}) {
+			return get<timer_counter>(name, help);
+		}
+
+		// Returns the summary named `name`, and creates it with the given quantiles if it doesn't exist yet. Throws std::invalid_argument if the name isn't a valid metric name, it's taken by another kind of metric, or a quantile isn't between 0 and 1.
+		timer_summary& summary(const std::string& name, const std::string& help = {}, std::vector<double> quantiles = { 0.5, 0.9, 0.99 }) {
+			return get<timer_summary>(name, help, std::move(quantiles));
+		}
+
+		// Returns the histogram named `name`, and creates it with the given bucket bounds if it doesn't exist yet. Throws std::invalid_argument if the name isn't a valid metric name, it's taken by another kind of metric, or the bounds aren't increasing.
+		timer_histogram& histogram(const std::string& name, const std::string& help = {}, std::vector<std::chrono::nanoseconds> bounds = default_bounds) {
+			return get<timer_histogram>(name, help, std::move(bounds));
+		}
+
+		// Writes every metric in the OpenMetrics text format, in the order they were created.
+		void render(std::ostream& out) const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			for (const auto& m : m_metrics) m->render(out);
+
+			out << "# EOF\n";
+		}
+
+		// Returns every metric in the OpenMetrics text format, in the order they were created.
+		[[nodiscard]] std::string render() const {
+			auto out = std::ostringstream();
+			render(out);
+			return out.str();
+		}
+
+	private:
+
+		mutable std::mutex							m_mutex;
+		std::vector<std::unique_ptr<timer_metric>>	m_metrics;
+
+		template <typename Metric, typename... Args>
+		Metric& get(const std::string& name, const std::string& help, Args&&... args) {
+			if (!detail::is_metric_name(name)) throw std::invalid_argument(name + " is not a valid metric name");
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			for (const auto& m : m_metrics) {
+				if (m->name() != name) continue;
+
+				const auto ret = dynamic_cast<Metric*>(m.get());
+				if (!ret) throw std::invalid_argument("Metric " + name + " already exists with a different type");
+
+				return *ret;
+			}
+
+			auto metric	= std::make_unique<Metric>(name, help, std::forward<Args>(args)...);
+			auto& ret	= *metric;
+
+			m_metrics.push_back(std::move(metric));
+
+			return ret;
+		}
+	};
+
+#ifndef _WIN32
+
+	// Serves the metrics of a registry over HTTP on a background thread, for a scraper on the same machine. It handles one connection at a time, which is plenty for a scraper; GET /metrics returns the metrics, anything else returns 404. Only available on POSIX systems.
+	class open_metrics_server {
+	public:
+
+		// Starts listening on `address`:`port`. A port of 0 picks a free one, see port(). Throws std::system_error if the socket can't be set up.
+		open_metrics_server(const open_metrics_registry& registry, std::uint16_t port, const std::string& address = "127.0.0.1") : m_registry{ &registry } {
+			m_socket = ::socket(AF_INET, SOCK_STREAM, 0);
+			if (m_socket < 0) throw_errno("Can't create a socket");
+
+			const int yes = 1;
+			::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+			sockaddr_in addr{};
+			addr.sin_family	= AF_INET;
+			addr.sin_port	= htons(port);
+
+			if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+				::close(m_socket);
+				throw std::invalid_argument(address + " is not an IPv4 address");
+			}
+
+			if (::bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(m_socket, 8) != 0) {
+				const auto error = errno;
+				::close(m_socket);
+				throw std::system_error(error, std::generic_category(), "Can't listen on " + address + ":" + std::to_string(port));
+			}
+
+			socklen_t size = sizeof(addr);
+			::getsockname(m_socket, reinterpret_cast<sockaddr*>(&addr), &size);
+			m_port = ntohs(addr.sin_port);
+
+			m_thread = std::thread([this] { serve(); });
+		}
+
+		// Stops the background thread, and closes the socket.
+		~open_metrics_server() {
+			m_stop = true;
+			m_thread.join();
+			::close(m_socket);
+		}
+
+		open_metrics_server(const open_metrics_server&)				= delete;
+		open_metrics_server& operator=(const open_metrics_server&)	= delete;
+
+		// Returns the port the server listens on.
+		[[nodiscard]] std::uint16_t port() const noexcept {
+			return m_port;
+		}
+
+	private:
+
+		const open_metrics_registry*	m_registry;
+		int								m_socket{ -1 };
+		std::uint16_t					m_port{};
+		std::atomic<bool>				m_stop{};
+		std::thread						m_thread;
+
+		void serve() {
+			while (!m_stop) {
+				// Waits in short steps, so the destructor doesn't have to wait long
+				pollfd p{ m_socket, POLLIN, 0 };
+				if (::poll(&p, 1, 100) <= 0) continue;
+
+				const int client = ::accept(m_socket, nullptr, nullptr);
+				if (client < 0) continue;
+
+				// A client that doesn't send a request doesn't hold up the server for long
+				timeval timeout{ 1, 0 };
+				::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+				::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+				respond(client);
+				::close(client);
+			}
+		}
+
+		void respond(int client) const {
+			auto request = std::string();
+			char buffer[1024];
+
+			// Only the request line matters, the rest of the request is read up to a limit and ignored
+			while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+				const auto n = ::recv(client, buffer, sizeof(buffer), 0);
+				if (n <= 0) return;
+
+				request.append(buffer, static_cast<std::size_t>(n));
+			}
+
+			const auto line	= request.substr(0, request.find("\r\n"));
+			auto body		= std::string();
+			auto status		= "200 OK";
+			auto type		= "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+			if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET /metrics?", 0) == 0) {
+				body = m_registry->render();
+			} else {
+				status	= "404 Not Found";
+				type	= "text/plain; charset=utf-8";
+				body	= "Not found\n";
+			}
+
+			auto response = "HTTP/1.1 " + std::string(status) + "\r\nContent-Type: " + type + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+			for (std::size_t sent{}; sent < response.size();) {
+#ifdef MSG_NOSIGNAL
+				const auto n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+				const auto n = ::send(client, response.data() + sent, response.size() - sent, 0);
+#endif
+				if (n <= 0) return;
+
+				sent += static_cast<std::size_t>(n);
+			}
+		}
+
+		[[noreturn]] static void throw_errno(const std::string& what) {
+			throw std::system_error(errno, std::generic_category(), what);
+		}
+	};
+
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_PRECISE_SLEEP_HPP_
+#define _A_PRECISE_SLEEP_HPP_
+
+#include "stopwatch.hpp"
+
+#include <cmath>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Hints the CPU that we're in a spin-wait loop.
+		inline void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+			__builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+			asm volatile("yield" ::: "memory");
+#endif
+		}
+
+	}
+
+	// Keeps track of how long a short sleep actually takes on this system, since the OS tends to overshoot it. The estimate is the mean plus one standard deviation of the observed lengths.
+	template <typename MonotonicTrivialClock>
+	class basic_sleep_calibration {
+	public:
+		using clock = std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+
+		// The length of a single coarse sleep.
+		static constexpr std::chrono::milliseconds quantum{ 1 };
+
+		// Records the actual length of a sleep that was requested to be `quantum` long.
+		void record(typename clock::duration actual) noexcept {
+			const auto observed = convert_time<d_nanoseconds>(actual).count();
+
+			// Capping the sample count lets the estimate follow changes in system load instead of settling forever.
+			if (m_samples < max_samples) m_samples++;
+
+			const auto delta = observed - m_mean;
+			m_mean	+= delta / static_cast<double>(m_samples);
+			m_m2	+= delta * (observed - m_mean);
+
+			if (m_samples == max_samples) m_m2 *= (max_samples - 1.0) / max_samples;
+		}
+
+		// Returns the expected actual length of a sleep that was requested to be `quantum` long.
+		[[nodiscard]] d_nanoseconds estimate() const noexcept {
+			if (m_samples < 2) return d_nanoseconds{ m_mean };
+
+			return d_nanoseconds{ m_mean + std::sqrt(m_m2 / static_cast<double>(m_samples - 1)) };
+		}
+
+		// Returns how many sleeps the estimate is based on.
+		[[nodiscard]] auto samples() const noexcept {
+			return m_samples;
+		}
+
+		// Returns the calibration data of the calling thread.
+		[[nodiscard]] static basic_sleep_calibration& this_thread() noexcept {
+			thread_local basic_sleep_calibration instance;
+			return instance;
+		}
+
+	private:
+
+		static constexpr int max_samples = 1000;
+
+		// Pessimistic starting point so the first call favors precision over CPU time.
+		double	m_mean{ 5e6 };
+		double	m_m2{};
+		int		m_samples{};
+	};
+
+	// Sleep calibration for std::chrono::steady_clock.
+	using sleep_calibration = basic_sleep_calibration<std::chrono::steady_clock>;
+
+	// Sleeps until the given time point. It sleeps in short steps while that is safe, then spin-waits for the rest of the time. `spin_budget` caps how long the spin-wait may last; past that the sleep is finished with a single coarse sleep, trading precision for CPU time.
+	template <typename MonotonicTrivialClock, typename Duration>
+	void precise_sleep_until(const std::chrono::time_point<MonotonicTrivialClock, Duration>& deadline, typename MonotonicTrivialClock::duration spin_budget = MonotonicTrivialClock::duration::max()) {
+		using clock = typename basic_sleep_calibration<MonotonicTrivialClock>::clock;
+
+		static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+		auto& calibration	= basic_sleep_calibration<clock>::this_thread();
+		auto timer			= basic_stopwatch<clock>();
+
+		while (deadline - clock::now() > std::chrono::ceil<typename clock::duration>(calibration.estimate())) {
+			timer.start();
+			std::this_thread::sleep_for(calibration.quantum);
+			calibration.record(timer.get_elapsed());
+		}
+
+		const auto remaining = deadline - clock::now();
+
+		if (remaining > spin_budget) {
+			std::this_thread::sleep_for(remaining - spin_budget);
+		}
+
+		while (clock::now() < deadline) {
+			detail::cpu_relax();
+		}
+	}
+
+	// Sleeps for the given duration. It sleeps in short steps while that is safe, then spin-waits for the rest of the time. `spin_budget` caps how long the spin-wait may last; past that the sleep is finished with a single coarse sleep, trading precision for CPU time.
+	template <typename Rep, typename Period>
+	void precise_sleep_for(const std::chrono::duration<Rep, Period>& duration, stopwatch::clock::duration spin_budget = stopwatch::clock::duration::max()) {
+		precise_sleep_until(stopwatch::clock::now() + std::chrono::ceil<stopwatch::clock::duration>(duration), spin_budget);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_RATE_LIMITER_HPP_
+#define _A_RATE_LIMITER_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Lock-free core of the rate limiters. The whole state is a single atomic word: the "theoretical arrival time" of GCRA, which is the time at which the limiter would be fully drained. A request for n units is allowed if moving that time forward by n intervals doesn't put it further than `burst` intervals ahead of now.
+		template <typename MonotonicTrivialClock>
+		class tat_limiter {
+		public:
+			using clock = std::enable_if_t<is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+
+			// The interval is capped, so that a full burst of intervals added to the current time can't overflow.
+			tat_limiter(std::int64_t interval_ns, std::int64_t burst) noexcept :
+				m_interval{ std::clamp<std::int64_t>(interval_ns, 1, std::numeric_limits<std::int64_t>::max() / 4 / std::max<std::int64_t>(burst, 1)) },
+				m_burst_offset{ m_interval * std::max<std::int64_t>(burst, 1) },
+				m_tat{ now_ns() }
+			{}
+
+			bool try_acquire(std::int64_t n) noexcept {
+				// More than a burst is never allowed, and would overflow with long intervals
+				if (n > m_burst_offset / m_interval) return false;
+
+				const auto now	= now_ns();
+				auto tat		= m_tat.load(std::memory_order_relaxed);
+
+				while (true) {
+					const auto new_tat = std::max(tat, now) + n * m_interval;
+
+					if (new_tat - m_burst_offset > now) return false;
+					if (m_tat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed)) return true;
+				}
+			}
+
+			std::int64_t wait_ns(std::int64_t n) const noexcept {
+				const auto now = now_ns();
+
+				return std::max<std::int64_t>(std::max(m_tat.load(std::memory_order_relaxed), now) + n * m_interval - m_burst_offset - now, 0);
+			}
+
+			std::int64_t drained_ns() const noexcept {
+				return std::max<std::int64_t>(m_tat.load(std::memory_order_relaxed) - now_ns(), 0);
+			}
+
+			std::int64_t interval_ns() const noexcept {
+				return m_interval;
+			}
+
+			std::int64_t burst() const noexcept {
+				return m_burst_offset / m_interval;
+			}
+
+			static std::int64_t now_ns() noexcept {
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+			}
+
+		private:
+			std::int64_t				m_interval;
+			std::int64_t				m_burst_offset;
+			std::atomic<std::int64_t>	m_tat;
+		};
+
+		// Returns the time between two tokens of a rate in nanoseconds. Rates that aren't positive, including NaN, and rates too slow to fit, give the longest interval, which tat_limiter caps.
+		inline std::int64_t rate_interval_ns(double per_second) noexcept {
+			if (!(per_second > 0)) return std::numeric_limits<std::int64_t>::max();
+
+			const auto ns = 1e9 / per_second;
+
+			return ns < 9e18 ? static_cast<std::int64_t>(std::llround(ns)) : std::numeric_limits<std::int64_t>::max();
+		}
+
+		// Returns an interval in nanoseconds, rounded up. Intervals too long to fit, including NaN ones, give the longest interval, and negative ones zero.
+		template <typename Rep, typename Period>
+		std::int64_t interval_ns(std::chrono::duration<Rep, Period> d) noexcept {
+			const auto ns = std::chrono::duration<double, std::nano>(d).count();
+
+			if (!(ns < 9e18)) return std::numeric_limits<std::int64_t>::max();
+
+			return ns > 0 ? static_cast<std::int64_t>(std::ceil(ns)) : 0;
+		}
+
+	}
+
+	// Lock-free token bucket rate limiter. Tokens are added at a fixed rate up to a capacity, and each request takes some. The state is a single atomic word, and a check reads the clock once. The bucket starts out full.
+	template <typename MonotonicTrivialClock>
+	class basic_token_bucket {
+	public:
+		using clock		= typename detail::tat_limiter<MonotonicTrivialClock>::clock;
+		using duration	= typename clock::duration;
+
+		// Creates a bucket that refills `tokens_per_second` tokens every second, and holds at most `capacity` tokens. The time between two tokens is rounded to whole nanoseconds. A rate that isn't positive, or NaN, practically never refills the bucket.
+		basic_token_bucket(double tokens_per_second, std::uint32_t capacity) noexcept :
+			m_core{ detail::rate_interval_ns(tokens_per_second), capacity }
+		{}
+
+		// Takes `n` tokens if there are enough. Returns false without taking any if there aren't.
+		[[nodiscard]] bool try_acquire(std::uint32_t n = 1) noexcept {
+			return m_core.try_acquire(n);
+		}
+
+		// Returns the number of tokens in the bucket right now.
+		[[nodiscard]] std::uint32_t available() const noexcept {
+			const auto missing = (m_core.drained_ns() + m_core.interval_ns() - 1) / m_core.interval_ns();
+
+			return static_cast<std::uint32_t>(std::max<std::int64_t>(m_core.burst() - missing, 0));
+		}
+
+		// Returns how long it takes until `n` tokens are available, or zero if they already are.
+		[[nodiscard]] duration time_until_available(std::uint32_t n = 1) const noexcept {
+			return std::chrono::ceil<duration>(std::chrono::nanoseconds(m_core.wait_ns(n)));
+		}
+
+		// Returns the maximum number of tokens in the bucket.
+		[[nodiscard]] std::uint32_t capacity() const noexcept {
+			return static_cast<std::uint32_t>(m_core.burst());
+		}
+
+	private:
+		detail::tat_limiter<MonotonicTrivialClock> m_core;
+	};
+
+	// Lock-free rate limiter using the generic cell rate algorithm (GCRA). Requests are allowed at one per `emission_interval` on average, with bursts of up to `burst` requests. The state is a single atomic word, and a check reads the clock once.
+	template <typename MonotonicTrivialClock>
+	class basic_gcra {
+	public:
+		using clock		= typename detail::tat_limiter<MonotonicTrivialClock>::clock;
+		using duration	= typename clock::duration;
+
+		// Creates a limiter allowing one request per `emission_interval` on average, and bursts of up to `burst` requests. Intervals of zero or less don't limit the rate, and intervals too long to hold a whole burst, or NaN, are capped.
+		template <typename Rep, typename Period>
+		basic_gcra(std::chrono::duration<Rep, Period> emission_interval, std::uint32_t burst) noexcept :
+			m_core{ detail::interval_ns(emission_interval), burst }
+		{}
+
+		// Allows `n` requests if they conform to the rate. Returns false if they don't, in which case nothing is recorded.
+		[[nodiscard]] bool try_acquire(std::uint32_t n = 1) noexcept {
+			return m_core.try_acquire(n);
+		}
+
+		// Returns how long it takes until `n` requests are allowed, or zero if they already are. This is what's usually sent back as "retry after".
+		[[nodiscard]] duration retry_after(std::uint32_t n = 1) const noexcept {
+			return std::chrono::ceil<duration>(std::chrono::nanoseconds(m_core.wait_ns(n)));
+		}
+
+		// Returns the average time between two requests.
+		[[nodiscard]] duration emission_interval() const noexcept {
+			return std::chrono::ceil<duration>(std::chrono::nanoseconds(m_core.interval_ns()));
+		}
+
+		// Returns the maximum burst size.
+		[[nodiscard]] std::uint32_t burst() const noexcept {
+			return static_cast<std::uint32_t>(m_core.burst());
+		}
+
+	private:
+		detail::tat_limiter<MonotonicTrivialClock> m_core;
+	};
+
+	// Token bucket using std::chrono::steady_clock.
+	using token_bucket = basic_token_bucket<std::chrono::steady_clock>;
+
+	// GCRA rate limiter using std::chrono::steady_clock.
+	using gcra = basic_gcra<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
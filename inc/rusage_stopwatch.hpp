@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_RUSAGE_STOPWATCH_HPP_
+#define _A_RUSAGE_STOPWATCH_HPP_
+
+#include "stopwatch.hpp"
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace sw {
+
+	// Counters of resource usage events that often explain why a section of code got slow.
+	struct resource_usage {
+		std::int64_t minor_faults{};			// Page faults served without I/O
+		std::int64_t major_faults{};			// Page faults that needed I/O
+		std::int64_t voluntary_switches{};		// Context switches because the thread blocked, such as on I/O or a lock
+		std::int64_t involuntary_switches{};	// Context switches because the thread was preempted
+
+		constexpr resource_usage& operator+=(const resource_usage& other) noexcept {
+			minor_faults			+= other.minor_faults;
+			major_faults			+= other.major_faults;
+			voluntary_switches		+= other.voluntary_switches;
+			involuntary_switches	+= other.involuntary_switches;
+			return *this;
+		}
+
+		constexpr resource_usage& operator-=(const resource_usage& other) noexcept {
+			minor_faults			-= other.minor_faults;
+			major_faults			-= other.major_faults;
+			voluntary_switches		-= other.voluntary_switches;
+			involuntary_switches	-= other.involuntary_switches;
+			return *this;
+		}
+
+		[[nodiscard]] friend constexpr resource_usage operator+(resource_usage a, const resource_usage& b) noexcept {
+			return a += b;
+		}
+
+		[[nodiscard]] friend constexpr resource_usage operator-(resource_usage a, const resource_usage& b) noexcept {
+			return a -= b;
+		}
+	};
+
+	// Returns the resource usage of the calling thread so far. Only supported on Linux, elsewhere every counter is 0.
+	inline resource_usage this_thread_resource_usage() noexcept {
+		auto ret = resource_usage();
+
+#ifdef __linux__
+		rusage usage{};
+
+		if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+			ret.minor_faults			= usage.ru_minflt;
+			ret.major_faults			= usage.ru_majflt;
+			ret.voluntary_switches		= usage.ru_nvcsw;
+			ret.involuntary_switches	= usage.ru_nivcsw;
+		}
+#endif
+
+		return ret;
+	}
+
+	// Stopwatch that also counts the page faults and context switches of the calling thread while it's running. It works the same way as basic_stopwatch, but it has to be started, paused and read on the same thread. Each start and pause costs a system call on top of the clock read.
+	template <typename MonotonicTrivialClock>
+	class basic_rusage_stopwatch {
+	public:
+		using clock = typename basic_stopwatch<MonotonicTrivialClock>::clock;
+
+		// Starts the stopwatch and returns the elapsed time, the same way as basic_stopwatch::start(). Restarting a running stopwatch clears the resource usage too.
+		auto start() noexcept {
+			const auto usage = this_thread_resource_usage();
+
+			if (!m_timer.is_paused()) m_accumulated = resource_usage();
+
+			m_resumed = usage;
+
+			return m_timer.start();
+		}
+
+		// Starts the stopwatch and returns the elapsed time, the same way as basic_stopwatch::start(). Restarting a running stopwatch clears the resource usage too.
+		template <typename Duration>
+		auto start() noexcept {
+			return convert_time<Duration>(start());
+		}
+
+		// Pauses the stopwatch.
+		void pause() noexcept {
+			if (m_timer.is_paused()) return;
+
+			m_timer.pause();
+			m_accumulated += this_thread_resource_usage() - m_resumed;
+		}
+
+		// Resets the stopwatch. It will be in a paused state with a time of 0 and no resource usage after this, just like a fresh instance.
+		void reset() noexcept {
+			*this = basic_rusage_stopwatch();
+		}
+
+		// Indicates if the stopwatch is paused.
+		[[nodiscard]] auto is_paused() const noexcept {
+			return m_timer.is_paused();
+		}
+
+		// Returns the elapsed time.
+		[[nodiscard]] auto get_elapsed() const noexcept {
+			return m_timer.get_elapsed();
+		}
+
+		// Returns the elapsed time.
+		template <typename Duration>
+		[[nodiscard]] auto get_elapsed() const noexcept {
+			return m_timer.template get_elapsed<Duration>();
+		}
+
+		// Returns the resource usage of the calling thread while the stopwatch was running.
+		[[nodiscard]] resource_usage get_usage() const noexcept {
+			if (m_timer.is_paused()) return m_accumulated;
+
+			return m_accumulated + (this_thread_resource_usage() - m_resumed);
+		}
+
+	private:
+
+		basic_stopwatch<clock>	m_timer;
+		resource_usage			m_accumulated;	// Usage of the running periods before the current one
+		resource_usage			m_resumed;		// Usage when the current running period started
+	};
+
+	// Stopwatch with resource usage, using std::chrono::steady_clock.
+	using rusage_stopwatch = basic_rusage_stopwatch<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_SAMPLED_SCOPE_HPP_
+#define _A_SAMPLED_SCOPE_HPP_
+
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace sw {
+
+	// Settings of a sampled timer that picks its own sampling period, so that reading the clock takes about `target_overhead` of the time of the timed code.
+	struct adaptive_sampling {
+		double						target_overhead{ 0.01 };	// Fraction of the time of the timed code, such as 0.01 for 1%
+		std::chrono::nanoseconds	clock_cost{};				// Cost of timing one call, which is two clock reads. Zero measures it.
+		std::uint32_t				max_period{ 1u << 20 };
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Seeds for the generators of sampled timers, so that timers created together don't sample the same calls
+		inline std::uint64_t next_sampling_seed() noexcept {
+			static std::atomic<std::uint64_t> counter{};
+
+			auto z	= (counter.fetch_add(1, std::memory_order_relaxed) + 1) * 0x9E3779B97F4A7C15;
+			z		= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z		= (z ^ (z >> 27)) * 0x94D049BB133111EB;
+
+			return (z ^ (z >> 31)) | 1;
+		}
+
+		// Measures the cost of timing one call with a clock: the two reads of a stopwatch that's started and read.
+		template <typename Clock>
+		std::chrono::nanoseconds measure_timing_cost() noexcept {
+			constexpr int reads = 1000;
+
+			const auto start = Clock::now();
+			for (int i{}; i < reads; i++) (void)Clock::now();
+			const auto elapsed = Clock::now() - start;
+
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed) * 2 / reads;
+		}
+
+	}
+
+	// Times a section on only some of its calls, to bound the cost of timing something that's as fast as reading the clock. On average 1 in `period` calls is timed, at random, and the others only decrement a counter. Each timed call is recorded with the number of calls it stands for, so the statistics estimate every call. Like basic_stopwatch, it's meant to be used from one thread; use one per thread, and merge their statistics.
+	template <typename MonotonicTrivialClock>
+	class basic_sampled_timer {
+	public:
+		using clock = std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+
+		// Times a section from its creation to its destruction, if the call was picked for sampling.
+		class scope {
+		public:
+			scope(const scope&)				= delete;
+			scope& operator=(const scope&)	= delete;
+
+			~scope() {
+				if (m_timer) m_timer->record(m_stopwatch.get_elapsed());
+			}
+
+			// Indicates if this call is timed.
+			[[nodiscard]] bool is_sampled() const noexcept {
+				return m_timer != nullptr;
+			}
+
+		private:
+			friend class basic_sampled_timer;
+
+			explicit scope(basic_sampled_timer* timer) noexcept : m_timer{ timer } {
+				if (m_timer) m_stopwatch.start();
+			}
+
+			basic_sampled_timer*	m_timer;
+			basic_stopwatch<clock>	m_stopwatch;
+		};
+
+		// Creates a timer that times 1 in `period` calls on average. A period of 1 times every call.
+		explicit basic_sampled_timer(std::uint32_t period = 64) noexcept : m_period{ std::max<std::uint32_t>(period, 1) } {
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			m_countdown = next_gap();
+		}
+
+		// Creates a timer that adjusts its period after each sample, so that timing takes about `settings.target_overhead` of the time of the timed code, given the mean duration of the samples so far. It starts by timing every call.
+		explicit basic_sampled_timer(const adaptive_sampling& settings) noexcept :
+			m_adaptive{ true },
+			m_target_overhead{ std::max(settings.target_overhead, 1e-9) },
+			m_max_period{ std::max<std::uint32_t>(settings.max_period, 1) },
+			m_clock_cost{ settings.clock_cost > settings.clock_cost.zero() ? settings.clock_cost : detail::measure_timing_cost<clock>() }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			m_countdown = next_gap();
+		}
+
+		// Counts a call, and returns a scope that times it if it's picked for sampling.
+		[[nodiscard]] scope measure() noexcept {
+			m_calls++;
+
+			if (--m_countdown != 0) return scope(nullptr);
+
+			return scope(this);
+		}
+
+		// Returns the estimated distribution of the durations of every call. Each sampled duration is recorded as many times as the calls it stands for, so count() is close to calls() and sum() estimates the total time.
+		[[nodiscard]] const duration_histogram& stats() const noexcept {
+			return m_stats;
+		}
+
+		// Returns the number of calls, sampled or not.
+		[[nodiscard]] std::uint64_t calls() const noexcept {
+			return m_calls;
+		}
+
+		// Returns the number of sampled calls.
+		[[nodiscard]] std::uint64_t samples() const noexcept {
+			return m_samples;
+		}
+
+		// Returns the current sampling period. It only changes with adaptive sampling.
+		[[nodiscard]] std::uint32_t period() const noexcept {
+			return m_period;
+		}
+
+		// Clears the statistics. The sampling period is kept.
+		void reset() noexcept {
+			m_stats.reset();
+			m_calls		= 0;
+			m_samples	= 0;
+			m_sampled	= 0;
+			m_counted	= 0;
+		}
+
+	private:
+
+		duration_histogram			m_stats;
+		std::uint64_t				m_calls{};
+		std::uint64_t				m_samples{};
+		std::uint64_t				m_counted{};		// Calls stood for by the samples so far
+		double						m_sampled{};		// Total of the sampled durations in nanoseconds, unscaled
+		std::uint64_t				m_countdown{};
+		std::uint64_t				m_rng{ detail::next_sampling_seed() };
+		std::uint32_t				m_period{ 1 };
+
+		bool						m_adaptive{};
+		double						m_target_overhead{};
+		std::uint32_t				m_max_period{};
+		std::chrono::nanoseconds	m_clock_cost{};
+
+		void record(typename clock::duration d) noexcept {
+			// The sample stands for every call since the previous one
+			const auto weight = m_calls - m_counted;
+
+			m_stats.record(d, weight);
+			m_counted	= m_calls;
+			m_samples++;
+			m_sampled	+= std::chrono::duration<double, std::nano>(d).count();
+
+			if (m_adaptive) {
+				// The overhead is the cost of timing a call over the time of the calls it stands for: cost / (period * mean)
+				const auto mean		= m_sampled / static_cast<double>(m_samples);
+				const auto period	= mean > 0.0 ? std::ceil(static_cast<double>(m_clock_cost.count()) / (m_target_overhead * mean)) : static_cast<double>(m_max_period);
+
+				m_period = static_cast<std::uint32_t>(std::clamp(period, 1.0, static_cast<double>(m_max_period)));
+			}
+
+			m_countdown = next_gap();
+		}
+
+		// The gap to the next sample is uniform between 1 and 2 * period - 1, which is period on average. It's random, so it doesn't line up with patterns in the calls.
+		std::uint64_t next_gap() noexcept {
+			if (m_period == 1) return 1;
+
+			m_rng ^= m_rng << 13;
+			m_rng ^= m_rng >> 7;
+			m_rng ^= m_rng << 17;
+
+			return 1 + m_rng % (2 * std::uint64_t{ m_period } - 1);
+		}
+	};
+
+	// Sampled timer using std::chrono::steady_clock.
+	using sampled_timer = basic_sampled_timer<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
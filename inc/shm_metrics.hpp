@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_SHM_METRICS_HPP_
+#define _A_SHM_METRICS_HPP_
+
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sw {
+
+	// The kind of statistics a shared memory metric holds.
+	enum class shm_metric_kind : std::uint32_t {
+		accumulator	= 1,	// A duration_accumulator
+		histogram	= 2		// A duration_histogram
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		inline constexpr char			shm_magic[8]	= { 'S', 'W', 'M', 'E', 'T', 'R', 'I', 'C' };
+		inline constexpr std::uint32_t	shm_version		= 1;
+		inline constexpr std::size_t	shm_name_size	= 48;
+
+		// The statistics are copied between processes as they are, so they have to stay plain data
+		static_assert(std::is_trivially_copyable_v<duration_accumulator> && std::is_trivially_copyable_v<duration_histogram>, "Metrics must be trivially copyable");
+
+		// The segment starts with this header, followed by `capacity` metrics of `slot_size` bytes. The sizes of the statistics are stored too, so a reader built with a different layout of them refuses the segment instead of misreading it.
+		struct shm_header {
+			char						magic[8];
+			std::uint32_t				version;
+			std::uint32_t				slot_size;
+			std::uint32_t				capacity;
+			std::atomic<std::uint32_t>	count;				// Number of metrics registered so far
+			std::uint64_t				pid;
+			std::uint32_t				accumulator_size;
+			std::uint32_t				histogram_size;
+			char						reserved[24];
+		};
+
+		// The seqlock of a metric is odd while it's being updated. Readers copy the statistics, and retry if the seqlock changed meanwhile.
+		struct shm_slot {
+			std::atomic<std::uint64_t>	seq;
+			shm_metric_kind				kind;
+			std::uint32_t				reserved;
+			char						name[shm_name_size];
+		};
+
+		static_assert(sizeof(shm_header) == 64 && sizeof(shm_slot) == 64, "Unexpected shared memory layout");
+		static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory needs lock-free atomics");
+
+		inline constexpr std::size_t shm_payload_size	= (std::max(sizeof(duration_accumulator), sizeof(duration_histogram)) + 63) / 64 * 64;
+		inline constexpr std::size_t shm_slot_size		= sizeof(shm_slot) + shm_payload_size;
+
+		// The statistics of a metric follow its slot header
+		inline void* shm_payload(shm_slot* slot) noexcept {
+			return reinterpret_cast<char*>(slot) + sizeof(shm_slot);
+		}
+
+		// POSIX needs the name of a segment to start with a slash
+		inline std::string shm_object_name(const std::string& name) {
+#ifdef _WIN32
+			return "Local\\" + name;
+#else
+			return name.empty() || name[0] != '/' ? "/" + name : name;
+#endif
+		}
+
+		// A mapping of a named shared memory segment. The creator maps it for writing and removes the name when it's destroyed; others map an existing one for reading.
+		class shm_mapping {
+		public:
+			// Creates the segment, or replaces an existing one with the same name.
+			shm_mapping(const std::string& name, std::size_t size) : m_name{ shm_object_name(name) }, m_size{ size }, m_owner{ true } {
+#ifdef _WIN32
+				m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), m_name.c_str());
+				if (!m_mapping) throw_last_error("Can't create " + name);
+
+				m_data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+				if (!m_data) {
+					CloseHandle(m_mapping);
+					throw_last_error("Can't map " + name);
+				}
+#else
+				const int fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+				if (fd < 0) throw_last_error("Can't create " + name);
+
+				if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+					::close(fd);
+					::shm_unlink(m_name.c_str());
+					throw_last_error("Can't resize " + name);
+				}
+
+				map(fd, PROT_READ | PROT_WRITE, name);
+#endif
+			}
+
+			// Maps an existing segment for reading.
+			explicit shm_mapping(const std::string& name) : m_name{ shm_object_name(name) } {
+#ifdef _WIN32
+				m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, m_name.c_str());
+				if (!m_mapping) throw_last_error("Can't open " + name);
+
+				m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+				if (!m_data) {
+					CloseHandle(m_mapping);
+					throw_last_error("Can't map " + name);
+				}
+
+				MEMORY_BASIC_INFORMATION info{};
+				VirtualQuery(m_data, &info, sizeof(info));
+				m_size = info.RegionSize;
+#else
+				const int fd = ::shm_open(m_name.c_str(), O_RDONLY, 0);
+				if (fd < 0) throw_last_error("Can't open " + name);
+
+				struct stat st{};
+				if (::fstat(fd, &st) != 0) {
+					::close(fd);
+					throw_last_error("Can't open " + name);
+				}
+
+				m_size = static_cast<std::size_t>(st.st_size);
+
+				if (m_size == 0) {
+					::close(fd);
+					throw std::runtime_error(name + " is empty");
+				}
+
+				map(fd, PROT_READ, name);
+#endif
+			}
+
+			~shm_mapping() {
+#ifdef _WIN32
+				UnmapViewOfFile(m_data);
+				CloseHandle(m_mapping);
+#else
+				::munmap(m_data, m_size);
+				if (m_owner) ::shm_unlink(m_name.c_str());
+#endif
+			}
+
+			shm_mapping(const shm_mapping&)				= delete;
+			shm_mapping& operator=(const shm_mapping&)	= delete;
+
+			void* data() const noexcept {
+				return m_data;
+			}
+
+			std::size_t size() const noexcept {
+				return m_size;
+			}
+
+		private:
+			std::string	m_name;
+			void*		m_data{};
+			std::size_t	m_size{};
+			bool		m_owner{};
+#ifdef _WIN32
+			HANDLE		m_mapping{};
+#endif
+
+#ifndef _WIN32
+			void map(int fd, int protection, const std::string& name) {
+				m_data = ::mmap(nullptr, m_size, protection, MAP_SHARED, fd, 0);
+				::close(fd);
+
+				if (m_data == MAP_FAILED) {
+					m_data = nullptr;
+					if (m_owner) ::shm_unlink(m_name.c_str());
+					throw_last_error("Can't map " + name);
+				}
+			}
+#endif
+
+			[[noreturn]] static void throw_last_error(const std::string& what) {
+#ifdef _WIN32
+				throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+				throw std::system_error(errno, std::generic_category(), what);
+#endif
+			}
+		};
+
+		inline std::uint64_t current_pid() noexcept {
+#ifdef _WIN32
+			return static_cast<std::uint64_t>(GetCurrentProcessId());
+#else
+			return static_cast<std::uint64_t>(::getpid());
+#endif
+		}
+
+	}
+
+	// A metric in a shared memory segment, holding the statistics of type `Stats`. It's a handle into the segment, so it's cheap to copy, and it's valid as long as the registry that created it.
+	template <typename Stats>
+	class shm_metric {
+	public:
+
+		// Records a duration. Recording from several threads at once is safe; they take turns through the seqlock of the metric.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d) noexcept {
+			auto seq = m_slot->seq.load(std::memory_order_relaxed);
+
+			// Taking the seqlock from even to odd also locks out the other writers
+			while (seq % 2 != 0 || !m_slot->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				if (seq % 2 != 0) {
+					std::this_thread::yield();
+					seq = m_slot->seq.load(std::memory_order_relaxed);
+				}
+			}
+
+			// Orders the odd sequence number before the changes, for readers
+			std::atomic_thread_fence(std::memory_order_release);
+
+			m_stats->record(d);
+
+			m_slot->seq.store(seq + 2, std::memory_order_release);
+		}
+
+		// Returns the name of the metric.
+		[[nodiscard]] const char* name() const noexcept {
+			return m_slot->name;
+		}
+
+	private:
+		friend class shm_metrics_registry;
+
+		explicit shm_metric(detail::shm_slot* slot) noexcept : m_slot{ slot }, m_stats{ static_cast<Stats*>(detail::shm_payload(slot)) } {}
+
+		detail::shm_slot*	m_slot;
+		Stats*				m_stats;
+	};
+
+	// A metric holding a duration_accumulator in shared memory.
+	using shm_accumulator	= shm_metric<duration_accumulator>;
+	// A metric holding a duration_histogram in shared memory.
+	using shm_histogram		= shm_metric<duration_histogram>;
+
+	// Places named timing statistics in a shared memory segment, where another process can read them with shm_metrics_reader at any time. Recording into them costs the same as recording into a local duration_accumulator or duration_histogram, plus taking a seqlock; there's no system call or other IPC on the recording side. The segment is removed when the registry is destroyed.
+	class shm_metrics_registry {
+	public:
+
+		// Creates the segment named `name`, with room for `capacity` metrics, or replaces an existing one with the same name. Throws std::system_error if the segment can't be created.
+		explicit shm_metrics_registry(const std::string& name, std::size_t capacity = 64) :
+			m_mapping{ name, sizeof(detail::shm_header) + capacity * detail::shm_slot_size },
+			m_capacity{ capacity }
+		{
+			auto header = new (m_mapping.data()) detail::shm_header{};
+
+			header->version				= detail::shm_version;
+			header->slot_size			= static_cast<std::uint32_t>(detail::shm_slot_size);
+			header->capacity			= static_cast<std::uint32_t>(capacity);
+			header->pid					= detail::current_pid();
+			header->accumulator_size	= static_cast<std::uint32_t>(sizeof(duration_accumulator));
+			header->histogram_size		= static_cast<std::uint32_t>(sizeof(duration_histogram));
+
+			// Readers don't accept the segment until the magic is there
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(header->magic, detail::shm_magic, sizeof(header->magic));
+
+			m_header = header;
+		}
+
+		shm_metrics_registry(const shm_metrics_registry&)				= delete;
+		shm_metrics_registry& operator=(const shm_metrics_registry&)	= delete;
+
+		// Returns the accumulator named `name`, and creates it if it doesn't exist yet. Names longer than 47 characters are cut off. Throws std::length_error if the segment is full, or std::invalid_argument if `name` is a histogram.
+		[[nodiscard]] shm_accumulator accumulator(const std::string& name) {
+			return shm_accumulator(find_or_add(name, shm_metric_kind::accumulator));
+		}
+
+		// Returns the histogram named `name`, and creates it if it doesn't exist yet. Names longer than 47 characters are cut off. Throws std::length_error if the segment is full, or std::invalid_argument if `name` is an accumulator.
+		[[nodiscard]] shm_histogram histogram(const std::string& name) {
+			return shm_histogram(find_or_add(name, shm_metric_kind::histogram));
+		}
+
+		// Returns the number of metrics.
+		[[nodiscard]] std::size_t size() const noexcept {
+			return m_header->count.load(std::memory_order_relaxed);
+		}
+
+		// Returns the number of metrics the segment has room for.
+		[[nodiscard]] std::size_t capacity() const noexcept {
+			return m_capacity;
+		}
+
+	private:
+
+		detail::shm_mapping		m_mapping;
+		std::size_t				m_capacity;
+		detail::shm_header*		m_header{};
+		std::mutex				m_mutex;
+
+		detail::shm_slot* slot(std::size_t index) const noexcept {
+			return reinterpret_cast<detail::shm_slot*>(static_cast<char*>(m_mapping.data()) + sizeof(detail::shm_header) + index * detail::shm_slot_size);
+		}
+
+		detail::shm_slot* find_or_add(const std::string& name, shm_metric_kind kind) {
+			const auto stored = name.substr(0, detail::shm_name_size - 1);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			const auto count = m_header->count.load(std::memory_order_relaxed);
+
+			for (std::size_t i{}; i < count; i++) {
+				const auto s = slot(i);
+
+				if (s->name != stored) continue;
+				if (s->kind != kind) throw std::invalid_argument("Metric " + stored + " already exists with a different kind");
+
+				return s;
+			}
+
+			if (count >= m_capacity) throw std::length_error("No room for metric " + stored);
+
+			const auto s = new (slot(count)) detail::shm_slot{};
+
+			s->kind = kind;
+			std::memcpy(s->name, stored.c_str(), stored.size());
+
+			if (kind == shm_metric_kind::accumulator) new (detail::shm_payload(s)) duration_accumulator();
+			else new (detail::shm_payload(s)) duration_histogram();
+
+			// Publishes the metric to readers
+			m_header->count.store(static_cast<std::uint32_t>(count + 1), std::memory_order_release);
+
+			return s;
+		}
+	};
+
+	// A consistent copy of a shared memory metric. Only the statistics of its kind are set.
+	struct shm_metric_snapshot {
+		std::string				name;
+		shm_metric_kind			kind;
+		duration_accumulator	accumulator;
+		duration_histogram		histogram;
+	};
+
+	// Reads the metrics of a shared memory segment created by shm_metrics_registry, usually in another process.
+	class shm_metrics_reader {
+	public:
+
+		// Maps the segment named `name` for reading. Throws std::system_error if it doesn't exist, or std::runtime_error if it isn't a metrics segment of a compatible version.
+		explicit shm_metrics_reader(const std::string& name) : m_mapping{ name } {
+			m_header = static_cast<const detail::shm_header*>(m_mapping.data());
+
+			if (m_mapping.size() < sizeof(detail::shm_header) || std::memcmp(m_header->magic, detail::shm_magic, sizeof(detail::shm_magic)) != 0) throw std::runtime_error(name + " is not a metrics segment");
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (m_header->version != detail::shm_version ||
+				m_header->slot_size != detail::shm_slot_size ||
+				m_header->accumulator_size != sizeof(duration_accumulator) ||
+				m_header->histogram_size != sizeof(duration_histogram) ||
+				m_mapping.size() < sizeof(detail::shm_header) + std::size_t{ m_header->capacity } * detail::shm_slot_size) throw std::runtime_error(name + " has an unsupported format");
+		}
+
+		// Returns a snapshot of every metric, in the order they were registered. Metrics that keep changing through many attempts to copy them are left out.
+		[[nodiscard]] std::vector<shm_metric_snapshot> read() const {
+			constexpr int max_attempts = 1000;
+
+			// The count is only trusted as far as the segment has room, since another process writes it
+			const auto count = std::min<std::size_t>(m_header->count.load(std::memory_order_acquire), m_header->capacity);
+
+			auto ret = std::vector<shm_metric_snapshot>();
+			ret.reserve(count);
+
+			for (std::size_t i{}; i < count; i++) {
+				const auto s = reinterpret_cast<const detail::shm_slot*>(static_cast<const char*>(m_mapping.data()) + sizeof(detail::shm_header) + i * detail::shm_slot_size);
+
+				auto snapshot = shm_metric_snapshot{ std::string(s->name, std::find(s->name, s->name + detail::shm_name_size, '\0')), s->kind, {}, {} };
+				void* target{};
+
+				if (s->kind == shm_metric_kind::accumulator) target = &snapshot.accumulator;
+				else if (s->kind == shm_metric_kind::histogram) target = &snapshot.histogram;
+				else continue;
+
+				const auto size = s->kind == shm_metric_kind::accumulator ? sizeof(duration_accumulator) : sizeof(duration_histogram);
+
+				for (int attempt{}; attempt < max_attempts; attempt++) {
+					const auto seq = s->seq.load(std::memory_order_acquire);
+
+					if (seq % 2 == 0) {
+						std::memcpy(target, reinterpret_cast<const char*>(s) + sizeof(detail::shm_slot), size);
+						std::atomic_thread_fence(std::memory_order_acquire);
+
+						if (s->seq.load(std::memory_order_relaxed) == seq) {
+							ret.push_back(std::move(snapshot));
+							break;
+						}
+					}
+
+					std::this_thread::yield();
+				}
+			}
+
+			return ret;
+		}
+
+		// Returns the id of the process that created the segment.
+		[[nodiscard]] std::uint64_t pid() const noexcept {
+			return m_header->pid;
+		}
+
+		// Returns the number of metrics the segment has room for.
+		[[nodiscard]] std::size_t capacity() const noexcept {
+			return m_header->capacity;
+		}
+
+	private:
+
+		detail::shm_mapping			m_mapping;
+		const detail::shm_header*	m_header{};
+	};
+}
+
+#endif
\ No newline at end of file
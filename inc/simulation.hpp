@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_SIMULATION_HPP_
+#define _A_SIMULATION_HPP_
+
+#include "manual_clock.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		struct sim_clock_tag {};
+
+	}
+
+	// The clock of simulations. It only moves when the simulation jumps to the next event.
+	using sim_clock = basic_manual_clock<detail::sim_clock_tag>;
+
+	// Discrete-event simulation driven by a basic_manual_clock. Events are kept in a binary heap, and running the simulation moves the clock straight to the next event instead of waiting for it. Events scheduled for the same time run in the order they were scheduled.
+	template <typename ManualClock>
+	class basic_simulation {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<ManualClock>, ManualClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+		using event_id		= std::uint64_t;
+		using action		= std::function<void()>;
+
+		// Schedules an action to run at the given time. If that time is already in the past, the action runs at the current time instead.
+		event_id schedule_at(time_point t, action a) {
+			const auto id = m_next_id++;
+
+			m_queue.push({ std::max(t, clock::now()), id });
+			m_actions.emplace(id, std::move(a));
+
+			return id;
+		}
+
+		// Schedules an action to run after the given amount of simulated time.
+		template <typename Rep, typename Period>
+		event_id schedule_after(std::chrono::duration<Rep, Period> d, action a) {
+			return schedule_at(clock::now() + std::chrono::ceil<duration>(d), std::move(a));
+		}
+
+		// Schedules an action to run when the stopwatch reaches the given elapsed time, assuming it keeps running until then. This is how timers and deadlines measured with a basic_stopwatch<clock> can join the simulation.
+		template <typename Rep, typename Period, typename... Policies>
+		event_id schedule_on_elapsed(const basic_stopwatch<clock, Policies...>& timer, std::chrono::duration<Rep, Period> elapsed, action a) {
+			return schedule_after(std::chrono::ceil<duration>(elapsed) - timer.get_elapsed(), std::move(a));
+		}
+
+		// Cancels a scheduled event. Returns false if the event has already run or was cancelled before.
+		bool cancel(event_id id) {
+			return m_actions.erase(id) != 0;
+		}
+
+		// Moves the clock to the next event and runs it. Returns false if there are no more events.
+		bool step() {
+			while (!m_queue.empty()) {
+				const auto next = m_queue.top();
+				m_queue.pop();
+
+				const auto it = m_actions.find(next.id);
+				if (it == m_actions.end()) continue; // Cancelled
+
+				auto a = std::move(it->second);
+				m_actions.erase(it);
+
+				clock::set(next.time);
+				a();
+
+				return true;
+			}
+
+			return false;
+		}
+
+		// Runs events until there are none left. Returns the number of events that ran.
+		std::size_t run() {
+			std::size_t count{};
+
+			while (step()) count++;
+
+			return count;
+		}
+
+		// Runs the events that are due by the given time, then moves the clock to that time. Returns the number of events that ran.
+		std::size_t run_until(time_point t) {
+			std::size_t count{};
+
+			while (has_pending() && next_event_time() <= t && step()) count++;
+
+			clock::set(t);
+
+			return count;
+		}
+
+		// Runs the events that are due within the given amount of simulated time, then moves the clock to the end of it. Returns the number of events that ran.
+		template <typename Rep, typename Period>
+		std::size_t run_for(std::chrono::duration<Rep, Period> d) {
+			return run_until(clock::now() + std::chrono::ceil<duration>(d));
+		}
+
+		// Indicates if there are events waiting to run.
+		[[nodiscard]] bool has_pending() noexcept {
+			discard_cancelled();
+
+			return !m_queue.empty();
+		}
+
+		// Returns the number of events waiting to run.
+		[[nodiscard]] std::size_t pending() const noexcept {
+			return m_actions.size();
+		}
+
+		// Returns the time of the next event. Only valid if has_pending() is true.
+		[[nodiscard]] time_point next_event_time() noexcept {
+			discard_cancelled();
+
+			return m_queue.top().time;
+		}
+
+	private:
+
+		struct event {
+			time_point	time;
+			event_id	id;
+
+			bool operator>(const event& other) const noexcept {
+				return time != other.time ? time > other.time : id > other.id;
+			}
+		};
+
+		std::priority_queue<event, std::vector<event>, std::greater<event>>	m_queue;
+		std::unordered_map<event_id, action>								m_actions;
+		event_id															m_next_id{};
+
+		void discard_cancelled() noexcept {
+			while (!m_queue.empty() && m_actions.find(m_queue.top().id) == m_actions.end()) m_queue.pop();
+		}
+	};
+
+	// Discrete-event simulation using sw::sim_clock.
+	using simulation = basic_simulation<sim_clock>;
+}
+
+#endif
\ No newline at end of file
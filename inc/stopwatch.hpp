@@ -9,6 +9,8 @@
 
 #include <type_traits>
 #include <chrono>
+#include <cstddef>
+#include <utility>
 
 namespace sw {
 
@@ -102,6 +104,9 @@ namespace sw {
 
 		using chrono_days = std::chrono::duration<int, std::ratio<86400>>; // Why doesn't this exist?
 
+		// The size of a cache line on the usual targets. std::hardware_destructive_interference_size isn't used, because it's missing from some standard libraries and GCC warns about using it in headers.
+		inline constexpr std::size_t cache_line_size = 64;
+
 	}
 
 	// Converts between duration types
@@ -156,59 +161,294 @@ namespace sw {
 		return ret;
 	}
 
-	// Stopwatch class for measuring time. The template argument is a clock type to be used.
-	template <typename MonotonicTrivialClock>
-	class basic_stopwatch {
-	public:
-		using clock = std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+	// Kinds of basic_stopwatch policies. A policy names its kind with a `policy_kind` member type.
+	struct storage_policy_kind {};
+	struct sync_policy_kind {};
+	struct laps_policy_kind {};
 
-		// Starts the stopwatch and returns the elapsed time. If the stopwatch has not been started yet, it starts it and returns a zero duration. If the stopwatch is paused, it resumes it. If the stopwatch is already running, it restarts it from 0 (this works as a "lap" function).
-		auto start() noexcept {
-			const auto now		= clock::now();
-			const auto snapshot	= get_elapsed_impl(now, m_start, m_pause_start);
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
 
-			if (has_value(m_pause_start)) {
-				m_start += (now - m_pause_start);
-				m_pause_start = zero_time_point;
-			} else {
-				m_start = now;
+		// The policy of a kind from a list, or Default if the list has none
+		template <typename Kind, typename Default, typename... Policies>
+		struct select_policy {
+			using type = Default;
+		};
+
+		template <typename Kind, typename Default, typename First, typename... Rest>
+		struct select_policy<Kind, Default, First, Rest...> {
+			using type = std::conditional_t<std::is_same_v<typename First::policy_kind, Kind>, First, typename select_policy<Kind, Default, Rest...>::type>;
+		};
+
+		template <typename Kind, typename Default, typename... Policies>
+		using select_policy_t = typename select_policy<Kind, Default, Policies...>::type;
+
+		template <typename Kind, typename... Policies>
+		inline constexpr std::size_t count_policies_v = (std::size_t{} + ... + std::size_t{ std::is_same_v<typename Policies::policy_kind, Kind> });
+
+		// The lap statistics of stopwatches that don't record laps
+		struct no_lap_stats {
+			template <typename Rep, typename Period>
+			constexpr void record(std::chrono::duration<Rep, Period>) noexcept {}
+		};
+
+	}
+
+	// Storage policy that keeps the time the stopwatch was started and the time it was paused, with the zero time point meaning "no value". It's the default, and it works with any clock.
+	struct split_storage {
+		using policy_kind = storage_policy_kind;
+
+		template <typename Clock>
+		class state {
+		public:
+
+			// Indicates if the stopwatch is paused.
+			[[nodiscard]] bool is_paused() const noexcept {
+				return has_value(m_pause_start) || !has_value(m_start);
 			}
 
-			return snapshot;
+			// Returns the elapsed time.
+			[[nodiscard]] typename Clock::duration elapsed() const noexcept {
+				return elapsed_impl(Clock::now());
+			}
+
+			// Starts, resumes or restarts the stopwatch, and returns the elapsed time before that.
+			typename Clock::duration start() noexcept {
+				return start(Clock::now());
+			}
+
+			// Same as start(), at the time `now`.
+			typename Clock::duration start(const typename Clock::time_point& now) noexcept {
+				const auto snapshot = elapsed_impl(now);
+
+				if (has_value(m_pause_start)) {
+					m_start += (now - m_pause_start);
+					m_pause_start = zero_time_point;
+				} else {
+					m_start = now;
+				}
+
+				return snapshot;
+			}
+
+			// Pauses the stopwatch if it's running.
+			void pause() noexcept {
+				if (!is_paused()) {
+					m_pause_start = Clock::now();
+				}
+			}
+
+		private:
+
+			static constexpr typename Clock::time_point zero_time_point{ Clock::duration::zero() };
+
+			typename Clock::time_point m_start{ zero_time_point }, m_pause_start{ zero_time_point };
+
+			static bool has_value(const typename Clock::time_point& t) noexcept {
+				return t != zero_time_point;
+			}
+
+			typename Clock::duration elapsed_impl(const typename Clock::time_point& now) const noexcept {
+				if (has_value(m_pause_start)) {
+					return m_pause_start - m_start;
+				}
+
+				if (has_value(m_start)) {
+					return now - m_start;
+				}
+
+				return Clock::duration::zero();
+			}
+		};
+	};
+
+	// Synchronization policy for stopwatches used by one thread at a time. It's the default, and it costs nothing.
+	struct no_sync {
+		using policy_kind = sync_policy_kind;
+
+		// Holds the state and the lap statistics of a stopwatch. Statistics that are empty take no space.
+		template <typename State, typename Laps>
+		class cell : private Laps {
+		public:
+
+			// Returns a copy of the state.
+			[[nodiscard]] State load() const noexcept {
+				return m_state;
+			}
+
+			// Calls `f` with the state to change it, and returns what it returns.
+			template <typename F>
+			decltype(auto) update(F&& f) noexcept {
+				return f(m_state);
+			}
+
+			// Adds a lap to the statistics.
+			template <typename Duration>
+			void record_lap(Duration d) noexcept {
+				Laps::record(d);
+			}
+
+			// Returns the lap statistics.
+			[[nodiscard]] const Laps& laps() const noexcept {
+				return *this;
+			}
+
+			// Puts the state and the statistics back to what they were after construction.
+			void reset() noexcept {
+				*this = cell();
+			}
+
+		private:
+
+			State m_state;
+		};
+	};
+
+	// Laps policy that doesn't record laps. It's the default.
+	struct no_laps {
+		using policy_kind	= laps_policy_kind;
+		using stats			= detail::no_lap_stats;
+	};
+
+	// Policy that turns a stopwatch off. It takes the place of the synchronization policy, which is the one holding the state, and holds nothing, so the stopwatch is an empty type whose methods are constexpr no-ops that never read the clock. It always reads as a fresh stopwatch: paused, with a time of 0 and no laps, whatever the other policies are.
+	struct disabled {
+		using policy_kind = sync_policy_kind;
+
+		template <typename State, typename Laps>
+		class cell {
+		public:
+			using duration = decltype(std::declval<const State&>().elapsed());
+
+			// The state of a fresh stopwatch, which nothing changes.
+			class fresh_state {
+			public:
+
+				// Always true.
+				[[nodiscard]] constexpr bool is_paused() const noexcept {
+					return true;
+				}
+
+				// Returns a zero duration.
+				[[nodiscard]] constexpr duration elapsed() const noexcept {
+					return duration::zero();
+				}
+
+				// Does nothing, and returns a zero duration.
+				constexpr duration start() noexcept {
+					return duration::zero();
+				}
+
+				// Does nothing, and returns a zero duration.
+				template <typename TimePoint>
+				constexpr duration start(const TimePoint&) noexcept {
+					return duration::zero();
+				}
+
+				// Does nothing.
+				constexpr void pause() noexcept {}
+			};
+
+			// Returns a fresh state.
+			[[nodiscard]] constexpr fresh_state load() const noexcept {
+				return fresh_state();
+			}
+
+			// Calls `f` with a fresh state, and returns what it returns.
+			template <typename F>
+			constexpr decltype(auto) update(F&& f) const noexcept {
+				auto s = fresh_state();
+
+				return f(s);
+			}
+
+			// Does nothing.
+			template <typename Duration>
+			constexpr void record_lap(Duration) const noexcept {}
+
+			// Returns empty lap statistics.
+			[[nodiscard]] constexpr Laps laps() const noexcept {
+				return Laps();
+			}
+
+			// Does nothing.
+			constexpr void reset() noexcept {}
+		};
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// What holds the state of a stopwatch: the cell of its synchronization policy, with the state of its storage policy and the statistics of its laps policy
+		template <typename Clock, typename... Policies>
+		using stopwatch_cell_t = typename select_policy_t<sync_policy_kind, no_sync, Policies...>::template cell<
+			typename select_policy_t<storage_policy_kind, split_storage, Policies...>::template state<Clock>,
+			typename select_policy_t<laps_policy_kind, no_laps, Policies...>::stats>;
+
+	}
+
+	// Stopwatch class for measuring time. The first template argument is a clock type to be used. The rest are optional policies, in any order, at most one of each kind:
+	//  - storage (split_storage by default, or packed_storage): how the state is kept,
+	//  - synchronization (no_sync by default, atomic_sync or seqlock_sync): if and how it can be used by several threads at once, or disabled, which turns the stopwatch off,
+	//  - laps (no_laps by default, lap_accumulator or lap_histogram): where the laps are recorded, if anywhere.
+	// The policies other than the defaults and disabled live in stopwatch_policies.hpp.
+	template <typename MonotonicTrivialClock, typename... Policies>
+	class basic_stopwatch : private detail::stopwatch_cell_t<MonotonicTrivialClock, Policies...> {
+	public:
+		using clock				= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using storage_policy	= detail::select_policy_t<storage_policy_kind, split_storage, Policies...>;
+		using sync_policy		= detail::select_policy_t<sync_policy_kind, no_sync, Policies...>;
+		using laps_policy		= detail::select_policy_t<laps_policy_kind, no_laps, Policies...>;
+
+		// Starts the stopwatch and returns the elapsed time. If the stopwatch has not been started yet, it starts it and returns a zero duration. If the stopwatch is paused, it resumes it. If the stopwatch is already running, it restarts it from 0 (this works as a "lap" function, and the lap is recorded by the laps policy).
+		constexpr auto start() noexcept {
+			return start_with([](auto& s) { return s.start(); });
 		}
-		
-		// Starts the stopwatch and returns the elapsed time. If the stopwatch has not been started yet, it starts it and returns a zero duration. If the stopwatch is paused, it resumes it. If the stopwatch is already running, it restarts it from 0 (this works as a "lap" function).
+
+		// Same as start(), at the time `now` that the caller read from the clock, so the same time can be used for something else, such as the timestamp of the lap. `now` must not be earlier than the times the stopwatch already used.
+		constexpr auto start(const typename clock::time_point& now) noexcept {
+			return start_with([&now](auto& s) { return s.start(now); });
+		}
+
+		// Starts the stopwatch and returns the elapsed time. If the stopwatch has not been started yet, it starts it and returns a zero duration. If the stopwatch is paused, it resumes it. If the stopwatch is already running, it restarts it from 0 (this works as a "lap" function, and the lap is recorded by the laps policy).
 		template <typename Duration>
-		auto start() noexcept {
+		constexpr auto start() noexcept {
 			return convert_time<Duration>(start());
 		}
 
 		// Pauses the stopwatch.
-		void pause() noexcept {
-			if (!is_paused()) {
-				m_pause_start = clock::now();
-			}
+		constexpr void pause() noexcept {
+			state_cell().update([](auto& s) {
+				s.pause();
+			});
 		}
 
-		// Resets the stopwatch. It will be in a paused state with a time of 0 after this, just like a fresh instance.
-		void reset() noexcept {
-			*this = basic_stopwatch<clock>();
+		// Resets the stopwatch. It will be in a paused state with a time of 0 after this, just like a fresh instance. The recorded laps are cleared too.
+		constexpr void reset() noexcept {
+			state_cell().reset();
 		}
 
 		// Indicates if the stopwatch is paused.
-		[[nodiscard]] auto is_paused() const noexcept {
-			return has_value(m_pause_start) || !has_value(m_start);
+		[[nodiscard]] constexpr auto is_paused() const noexcept {
+			return state_cell().load().is_paused();
 		}
 
 		// Returns the elapsed time.
-		[[nodiscard]] auto get_elapsed() const noexcept {
-			return get_elapsed_impl(clock::now(), m_start, m_pause_start);
+		[[nodiscard]] constexpr auto get_elapsed() const noexcept {
+			return state_cell().load().elapsed();
 		}
 
 		// Returns the elapsed time.
 		template <typename Duration>
-		[[nodiscard]] auto get_elapsed() const noexcept {
-			return convert_time<Duration>(get_elapsed_impl(clock::now(), m_start, m_pause_start));
+		[[nodiscard]] constexpr auto get_elapsed() const noexcept {
+			return convert_time<Duration>(get_elapsed());
+		}
+
+		// Returns the statistics of the laps: the times returned by start() calls that restarted a running stopwatch. Only available with a laps policy that records them.
+		template <typename Laps = laps_policy>
+		[[nodiscard]] constexpr decltype(auto) laps() const noexcept {
+			static_assert(!std::is_same_v<Laps, no_laps>, "This stopwatch doesn't record laps");
+
+			return state_cell().laps();
 		}
 
 	private:
@@ -216,29 +456,66 @@ namespace sw {
 		static_assert(clock::is_steady, "Only monotonic clocks can be used");
 		static_assert(detail::is_trivial_clock_v<clock>, "Clock must satisfy the requirements of TrivialClock");
 
-		static constexpr typename clock::time_point zero_time_point{ clock::duration::zero() };
+		static_assert(detail::count_policies_v<storage_policy_kind, Policies...> <= 1, "Only one storage policy can be used");
+		static_assert(detail::count_policies_v<sync_policy_kind, Policies...> <= 1, "Only one synchronization policy can be used, and disabled counts as one");
+		static_assert(detail::count_policies_v<laps_policy_kind, Policies...> <= 1, "Only one laps policy can be used");
+		static_assert(detail::count_policies_v<storage_policy_kind, Policies...> + detail::count_policies_v<sync_policy_kind, Policies...> + detail::count_policies_v<laps_policy_kind, Policies...> == sizeof...(Policies), "Unknown policy kind");
 
-		typename clock::time_point m_start{ zero_time_point }, m_pause_start{ zero_time_point };
+		// The cell is a base rather than a member, so that an empty one takes no space
+		using cell_type = detail::stopwatch_cell_t<MonotonicTrivialClock, Policies...>;
 
-		static inline bool has_value(const typename clock::time_point& t) noexcept {
-			return t != zero_time_point;
+		constexpr cell_type& state_cell() noexcept {
+			return *this;
 		}
 
-		static inline auto get_elapsed_impl(const typename clock::time_point& now, const typename clock::time_point& start, const typename clock::time_point& pause_start) noexcept {
-			if (has_value(pause_start)) {
-				return pause_start - start;
-			}
+		constexpr const cell_type& state_cell() const noexcept {
+			return *this;
+		}
 
-			if (has_value(start)) {
-				return now - start;
-			}
+		// Starts the state with `start_state`, and records the lap if it was running
+		template <typename F>
+		constexpr auto start_with(F&& start_state) noexcept {
+			const auto [snapshot, lap] = state_cell().update([&](auto& s) {
+				const auto running = !s.is_paused();
 
-			return clock::duration::zero();
+				return std::pair<typename clock::duration, bool>(start_state(s), running);
+			});
+
+			if (lap) state_cell().record_lap(snapshot);
+
+			return snapshot;
 		}
 	};
 
 	// Stopwatch class for measuring time. Defaulted to using std::chrono::steady_clock.
 	using stopwatch = basic_stopwatch<std::chrono::steady_clock>;
+
+	// A stopwatch that does nothing, with the interface and the result types of basic_stopwatch, so timing code that uses it compiles to nothing. See the disabled policy.
+	template <typename MonotonicTrivialClock>
+	using basic_disabled_stopwatch = basic_stopwatch<MonotonicTrivialClock, disabled>;
+
+	// Disabled stopwatch using std::chrono::steady_clock.
+	using disabled_stopwatch = basic_disabled_stopwatch<std::chrono::steady_clock>;
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// basic_stopwatch, or basic_disabled_stopwatch if `Enabled` is false
+		template <typename MonotonicTrivialClock, bool Enabled>
+		using instrumentation_stopwatch_t = std::conditional_t<Enabled, basic_stopwatch<MonotonicTrivialClock>, basic_disabled_stopwatch<MonotonicTrivialClock>>;
+
+	}
+
+	// Stopwatch for instrumentation that can be compiled out. It's basic_stopwatch, unless SW_DISABLE_INSTRUMENTATION is defined, in which case it's basic_disabled_stopwatch. The macro has to be the same in every translation unit of a program, or this type has two definitions.
+	template <typename MonotonicTrivialClock>
+#ifdef SW_DISABLE_INSTRUMENTATION
+	using basic_instrumentation_stopwatch = detail::instrumentation_stopwatch_t<MonotonicTrivialClock, false>;
+#else
+	using basic_instrumentation_stopwatch = detail::instrumentation_stopwatch_t<MonotonicTrivialClock, true>;
+#endif
+
+	// Instrumentation stopwatch using std::chrono::steady_clock.
+	using instrumentation_stopwatch = basic_instrumentation_stopwatch<std::chrono::steady_clock>;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_STOPWATCH_ARRAY_HPP_
+#define _A_STOPWATCH_ARRAY_HPP_
+
+#include "stopwatch.hpp"
+
+#include <memory>
+
+namespace sw {
+
+	// A fixed number of stopwatches, such as one per worker thread, each on its own cache line. Stopwatches next to each other in a plain array share cache lines, so threads using neighboring ones keep taking the line from each other (false sharing), even though they never touch the same stopwatch. The template arguments are the same as those of basic_stopwatch.
+	template <typename MonotonicTrivialClock, typename... Policies>
+	class basic_stopwatch_array {
+	public:
+		using stopwatch_type = basic_stopwatch<MonotonicTrivialClock, Policies...>;
+
+		// Creates `size` stopwatches, in the same state as fresh ones.
+		explicit basic_stopwatch_array(std::size_t size) :
+			m_size{ size },
+			m_slots{ std::make_unique<slot[]>(size) }
+		{}
+
+		basic_stopwatch_array(const basic_stopwatch_array&)				= delete;
+		basic_stopwatch_array& operator=(const basic_stopwatch_array&)	= delete;
+
+		basic_stopwatch_array(basic_stopwatch_array&&) noexcept				= default;
+		basic_stopwatch_array& operator=(basic_stopwatch_array&&) noexcept	= default;
+
+		// Returns the stopwatch at `index`, which must be less than size().
+		[[nodiscard]] stopwatch_type& operator[](std::size_t index) noexcept {
+			return m_slots[index].stopwatch;
+		}
+
+		// Returns the stopwatch at `index`, which must be less than size().
+		[[nodiscard]] const stopwatch_type& operator[](std::size_t index) const noexcept {
+			return m_slots[index].stopwatch;
+		}
+
+		// Returns the number of stopwatches.
+		[[nodiscard]] std::size_t size() const noexcept {
+			return m_size;
+		}
+
+		// Resets every stopwatch.
+		void reset() noexcept {
+			for (std::size_t i{}; i < m_size; i++) m_slots[i].stopwatch.reset();
+		}
+
+	private:
+
+		// The alignment also pads the size to a multiple of a cache line, so the next slot starts on a new one
+		struct alignas(detail::cache_line_size) slot {
+			stopwatch_type stopwatch;
+		};
+
+		std::size_t				m_size;
+		std::unique_ptr<slot[]>	m_slots;
+	};
+
+	// Stopwatch array using std::chrono::steady_clock.
+	using stopwatch_array = basic_stopwatch_array<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_STOPWATCH_POLICIES_HPP_
+#define _A_STOPWATCH_POLICIES_HPP_
+
+#include "timing_stats.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Lap statistics with the spinlock that guards them. Empty statistics need no lock, and take no space.
+		template <typename Laps, bool = std::is_empty_v<Laps>>
+		struct locked_laps : Laps {
+			mutable std::atomic<bool> locked{};
+		};
+
+		template <typename Laps>
+		struct locked_laps<Laps, true> : Laps {};
+
+	}
+
+	// Storage policy that packs the state of a stopwatch into a single 64-bit word: the start time while it's running, or the elapsed time while it's paused, with the state in the lowest 2 bits. It halves the size of a stopwatch, and lets atomic_sync update it lock-free. It needs a clock with an integer representation of up to 64 bits, whose values fit in 62 bits.
+	struct packed_storage {
+		using policy_kind = storage_policy_kind;
+
+		template <typename Clock>
+		class state {
+		public:
+			static_assert(std::is_integral_v<typename Clock::rep> && sizeof(typename Clock::rep) <= sizeof(std::uint64_t), "packed_storage needs a clock with an integer representation of up to 64 bits");
+
+			// Indicates if the stopwatch is paused.
+			[[nodiscard]] bool is_paused() const noexcept {
+				return mode() != running;
+			}
+
+			// Returns the elapsed time.
+			[[nodiscard]] typename Clock::duration elapsed() const noexcept {
+				switch (mode()) {
+				case running:	return Clock::now().time_since_epoch() - value();
+				case paused:	return value();
+				default:		return Clock::duration::zero();
+				}
+			}
+
+			// Starts, resumes or restarts the stopwatch, and returns the elapsed time before that.
+			typename Clock::duration start() noexcept {
+				return start(Clock::now());
+			}
+
+			// Same as start(), at the time `t`.
+			typename Clock::duration start(const typename Clock::time_point& t) noexcept {
+				const auto now = t.time_since_epoch();
+
+				switch (mode()) {
+				case running: {
+					const auto snapshot = now - value();
+					set(running, now);
+					return snapshot;
+				}
+				case paused: {
+					const auto snapshot = value();
+					set(running, now - snapshot);
+					return snapshot;
+				}
+				default:
+					set(running, now);
+					return Clock::duration::zero();
+				}
+			}
+
+			// Pauses the stopwatch if it's running.
+			void pause() noexcept {
+				if (mode() == running) set(paused, Clock::now().time_since_epoch() - value());
+			}
+
+		private:
+
+			// What the stored value means
+			static constexpr std::uint64_t idle		= 0;	// Nothing, the stopwatch was never started
+			static constexpr std::uint64_t running	= 1;	// The time the stopwatch was started, as if it was never paused
+			static constexpr std::uint64_t paused	= 2;	// The elapsed time
+
+			std::uint64_t m_bits{};
+
+			std::uint64_t mode() const noexcept {
+				return m_bits & 3;
+			}
+
+			typename Clock::duration value() const noexcept {
+				return typename Clock::duration(static_cast<typename Clock::rep>(static_cast<std::int64_t>(m_bits) >> 2));
+			}
+
+			void set(std::uint64_t mode, typename Clock::duration value) noexcept {
+				m_bits = static_cast<std::uint64_t>(static_cast<std::int64_t>(value.count())) << 2 | mode;
+			}
+		};
+	};
+
+	// Synchronization policy that keeps the state of a stopwatch in a std::atomic, so it can be started, paused and read by several threads at once without locking. Each change is a compare-and-swap loop, which reads the clock again when it retries, unless the time was given to start(). Laps are recorded under a spinlock. The state has to fit in a lock-free atomic, which packed_storage does; use seqlock_sync for others.
+	struct atomic_sync {
+		using policy_kind = sync_policy_kind;
+
+		template <typename State, typename Laps>
+		class cell : private detail::locked_laps<Laps> {
+		public:
+			static_assert(std::atomic<State>::is_always_lock_free, "atomic_sync needs a state that fits in a lock-free atomic, such as packed_storage; use seqlock_sync for others");
+
+			// Returns a copy of the state.
+			[[nodiscard]] State load() const noexcept {
+				return m_state.load(std::memory_order_acquire);
+			}
+
+			// Calls `f` with a copy of the state to change it, and stores the result if the state didn't change meanwhile. Otherwise calls `f` again. Returns what the successful call returned.
+			template <typename F>
+			auto update(F&& f) noexcept {
+				auto expected = m_state.load(std::memory_order_relaxed);
+
+				while (true) {
+					auto desired = expected;
+
+					if constexpr (std::is_void_v<decltype(f(desired))>) {
+						f(desired);
+
+						if (m_state.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_relaxed)) return;
+					} else {
+						auto ret = f(desired);
+
+						if (m_state.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_relaxed)) return ret;
+					}
+				}
+			}
+
+			// Adds a lap to the statistics.
+			template <typename Duration>
+			void record_lap(Duration d) noexcept {
+				if constexpr (!std::is_empty_v<Laps>) {
+					lock();
+					Laps::record(d);
+					unlock();
+				}
+			}
+
+			// Returns a copy of the lap statistics.
+			[[nodiscard]] Laps laps() const noexcept {
+				lock();
+				auto ret = static_cast<const Laps&>(*this);
+				unlock();
+
+				return ret;
+			}
+
+			// Puts the state and the statistics back to what they were after construction.
+			void reset() noexcept {
+				if constexpr (!std::is_empty_v<Laps>) {
+					lock();
+					static_cast<Laps&>(*this) = Laps();
+					m_state.store(State(), std::memory_order_release);
+					unlock();
+				} else {
+					m_state.store(State(), std::memory_order_release);
+				}
+			}
+
+		private:
+
+			std::atomic<State> m_state{ State() };
+
+			void lock() const noexcept {
+				while (this->locked.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+			}
+
+			void unlock() const noexcept {
+				this->locked.store(false, std::memory_order_release);
+			}
+		};
+	};
+
+	// Synchronization policy that guards the state and the lap statistics of a stopwatch with a seqlock. Writers take turns, and readers copy the state without writing anything, retrying if a writer changed it meanwhile. It works with any storage and laps policy.
+	struct seqlock_sync {
+		using policy_kind = sync_policy_kind;
+
+		template <typename State, typename Laps>
+		class cell : private Laps {
+		public:
+
+			// Returns a copy of the state.
+			[[nodiscard]] State load() const noexcept {
+				return read(m_state);
+			}
+
+			// Calls `f` with the state to change it while no one else can, and returns what it returns.
+			template <typename F>
+			decltype(auto) update(F&& f) noexcept {
+				const auto guard = write_guard(*this);
+
+				return f(m_state);
+			}
+
+			// Adds a lap to the statistics.
+			template <typename Duration>
+			void record_lap(Duration d) noexcept {
+				if constexpr (!std::is_empty_v<Laps>) {
+					const auto guard = write_guard(*this);
+
+					Laps::record(d);
+				}
+			}
+
+			// Returns a copy of the lap statistics.
+			[[nodiscard]] Laps laps() const noexcept {
+				return read(static_cast<const Laps&>(*this));
+			}
+
+			// Puts the state and the statistics back to what they were after construction.
+			void reset() noexcept {
+				const auto guard = write_guard(*this);
+
+				static_cast<Laps&>(*this) = Laps();
+				m_state = State();
+			}
+
+		private:
+
+			// Odd while a writer is changing something
+			mutable std::atomic<std::uint32_t>	m_seq{};
+			State								m_state;
+
+			// Takes the seqlock from even to odd, which also locks out the other writers, and makes it even again when it's destroyed
+			class write_guard {
+			public:
+				explicit write_guard(cell& owner) noexcept : m_owner{ owner } {
+					m_seq = m_owner.m_seq.load(std::memory_order_relaxed);
+
+					while (m_seq % 2 != 0 || !m_owner.m_seq.compare_exchange_weak(m_seq, m_seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+						if (m_seq % 2 != 0) {
+							std::this_thread::yield();
+							m_seq = m_owner.m_seq.load(std::memory_order_relaxed);
+						}
+					}
+
+					// Orders the odd sequence number before the changes, for readers
+					std::atomic_thread_fence(std::memory_order_release);
+				}
+
+				~write_guard() {
+					m_owner.m_seq.store(m_seq + 2, std::memory_order_release);
+				}
+
+				write_guard(const write_guard&)				= delete;
+				write_guard& operator=(const write_guard&)	= delete;
+
+			private:
+				cell&			m_owner;
+				std::uint32_t	m_seq{};
+			};
+
+			template <typename T>
+			T read(const T& source) const noexcept {
+				static_assert(std::is_trivially_copyable_v<T>, "seqlock_sync needs trivially copyable states and lap statistics");
+
+				T ret;
+
+				while (true) {
+					const auto seq = m_seq.load(std::memory_order_acquire);
+
+					if (seq % 2 == 0) {
+						std::memcpy(static_cast<void*>(&ret), &source, sizeof(T));
+						std::atomic_thread_fence(std::memory_order_acquire);
+
+						if (m_seq.load(std::memory_order_relaxed) == seq) return ret;
+					}
+
+					std::this_thread::yield();
+				}
+			}
+		};
+	};
+
+	// Laps policy that records the laps of a stopwatch in a duration_accumulator.
+	struct lap_accumulator {
+		using policy_kind	= laps_policy_kind;
+		using stats			= duration_accumulator;
+	};
+
+	// Laps policy that records the laps of a stopwatch in a duration_histogram.
+	struct lap_histogram {
+		using policy_kind	= laps_policy_kind;
+		using stats			= duration_histogram;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_TASK_TIMING_HPP_
+#define _A_TASK_TIMING_HPP_
+
+#include "thread_bindings.hpp"
+#include "timing_stats.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace sw {
+
+	// Timing statistics of the tasks run by a thread pool.
+	struct task_timing_stats {
+		duration_histogram	queue_delay;	// Time from wrapping a task to the start of its execution
+		duration_histogram	run_time;		// Time the task ran for
+
+		// Adds the statistics of another instance to this one.
+		void merge(const task_timing_stats& other) noexcept {
+			queue_delay.merge(other.queue_delay);
+			run_time.merge(other.run_time);
+		}
+	};
+
+	// Separates how long thread pool tasks wait in the queue from how long they run. Tasks are wrapped when they're enqueued, which records the time, and the wrapper records both durations when it's run. Each worker thread records into its own slot, and the slots are only merged when the statistics are read.
+	template <typename MonotonicTrivialClock>
+	class basic_task_timing {
+	public:
+		using clock = std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+
+		// Callable returned by wrap(). Calling it calls the wrapped task with the same result, and records its timing. It must not outlive the basic_task_timing that created it.
+		template <typename Task>
+		class timed_task {
+		public:
+
+			decltype(auto) operator()() {
+				const recorder r{ *m_owner, m_enqueued };
+				return m_task();
+			}
+
+		private:
+			friend class basic_task_timing;
+
+			timed_task(basic_task_timing& owner, Task task) :
+				m_owner{ &owner },
+				m_enqueued{ clock::now() },
+				m_task{ std::move(task) }
+			{}
+
+			basic_task_timing*				m_owner;
+			typename clock::time_point		m_enqueued;
+			Task							m_task;
+		};
+
+		// Creates an instance with slots for the given number of workers.
+		explicit basic_task_timing(std::size_t workers) :
+			m_workers{ workers },
+			m_slots{ std::make_unique<slot[]>(workers + 1) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+		}
+
+		basic_task_timing(const basic_task_timing&)				= delete;
+		basic_task_timing& operator=(const basic_task_timing&)	= delete;
+
+		// Wraps a task. The enqueue time is taken here, so this should be called right before pushing the task to the queue.
+		template <typename Task>
+		[[nodiscard]] timed_task<std::decay_t<Task>> wrap(Task&& task) {
+			return timed_task<std::decay_t<Task>>(*this, std::forward<Task>(task));
+		}
+
+		// Makes the calling thread record into the slot of worker `index`. Every worker thread should call this once before running tasks. Tasks run by other threads, or by a thread given an index beyond the number of workers, record into a shared slot.
+		void attach_worker(std::size_t index) noexcept {
+			m_bindings.bind(std::make_shared<worker_binding>(index < m_workers ? index : m_workers));
+		}
+
+		// Returns the merged statistics of every worker and the shared slot.
+		[[nodiscard]] task_timing_stats stats() const {
+			auto ret = task_timing_stats();
+
+			for (std::size_t i{}; i <= m_workers; i++) {
+				std::lock_guard<std::mutex> lock(m_slots[i].mutex);
+				ret.merge(m_slots[i].stats);
+			}
+
+			return ret;
+		}
+
+		// Returns the statistics of a single worker. An index equal to the number of workers returns those of the shared slot.
+		[[nodiscard]] task_timing_stats worker_stats(std::size_t index) const {
+			std::lock_guard<std::mutex> lock(m_slots[index].mutex);
+			return m_slots[index].stats;
+		}
+
+		// Returns the number of workers.
+		[[nodiscard]] std::size_t workers() const noexcept {
+			return m_workers;
+		}
+
+		// Clears the statistics.
+		void reset() {
+			for (std::size_t i{}; i <= m_workers; i++) {
+				std::lock_guard<std::mutex> lock(m_slots[i].mutex);
+				m_slots[i].stats = task_timing_stats();
+			}
+		}
+
+	private:
+
+		// The mutex is only ever contended while the statistics are read
+		struct alignas(detail::cache_line_size) slot {
+			mutable std::mutex	mutex;
+			task_timing_stats	stats;
+		};
+
+		// The slot a worker thread records into
+		struct worker_binding {
+			explicit worker_binding(std::size_t slot_index) noexcept : index{ slot_index } {}
+
+			std::size_t			index;
+			std::atomic<bool>	alive{ true };
+		};
+
+		// Records the timing of a task when it goes out of scope, so that tasks that throw are recorded too
+		struct recorder {
+			basic_task_timing&				owner;
+			typename clock::time_point		enqueued;
+			typename clock::time_point		start{ clock::now() };
+
+			~recorder() {
+				owner.record(start - enqueued, clock::now() - start);
+			}
+		};
+
+		std::size_t								m_workers;
+		std::unique_ptr<slot[]>					m_slots;
+		detail::thread_bindings<worker_binding>	m_bindings;
+
+		void record(typename clock::duration queue_delay, typename clock::duration run_time) {
+			const auto* worker = m_bindings.find();
+
+			auto& s = m_slots[worker ? worker->index : m_workers];
+
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.stats.queue_delay.record(queue_delay);
+			s.stats.run_time.record(run_time);
+		}
+	};
+
+	// Task timing using std::chrono::steady_clock.
+	using task_timing = basic_task_timing<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_THREAD_BINDINGS_HPP_
+#define _A_THREAD_BINDINGS_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Binds the threads that use an instance to their own slot of it, such as a buffer of records. Each thread keeps a list of its slots in the instances it used. `Slot` must have an `std::atomic<bool> alive` member, which is cleared when its thread exits, so the owner can free it. Bindings to destroyed instances are dropped by the next lookup of the thread, or right away for the thread that destroys the instance, so threads don't keep the slots of instances that are gone.
+		template <typename Slot>
+		class thread_bindings {
+		public:
+			thread_bindings() = default;
+
+			~thread_bindings() {
+				auto& list = t_list.bindings;
+
+				list.erase(std::remove_if(list.begin(), list.end(), [this](const binding& b) { return b.key == m_token.get(); }), list.end());
+			}
+
+			thread_bindings(const thread_bindings&)				= delete;
+			thread_bindings& operator=(const thread_bindings&)	= delete;
+
+			// Returns the slot of the calling thread, or nullptr if it has none.
+			[[nodiscard]] Slot* find() noexcept {
+				auto& list = t_list.bindings;
+
+				Slot* ret{};
+
+				// The instance of each binding is checked on the way, and the bindings of those that are gone are dropped
+				list.erase(std::remove_if(list.begin(), list.end(), [&](const binding& b) {
+					if (b.owner.expired()) return true;
+					if (b.key == m_token.get()) ret = b.slot.get();
+
+					return false;
+				}), list.end());
+
+				return ret;
+			}
+
+			// Makes `slot` the slot of the calling thread, replacing the one it had.
+			void bind(std::shared_ptr<Slot> slot) {
+				auto& list = t_list.bindings;
+
+				for (auto& b : list) {
+					if (b.key == m_token.get()) {
+						b.slot->alive.store(false, std::memory_order_release);
+						b.slot = std::move(slot);
+						return;
+					}
+				}
+
+				list.push_back({ m_token, m_token.get(), std::move(slot) });
+			}
+
+		private:
+
+			// The token lives as long as the instance. Bindings hold a weak reference to it, which also keeps its address from being reused by another instance while they exist.
+			struct binding {
+				std::weak_ptr<char>			owner;
+				const char*					key;
+				std::shared_ptr<Slot>		slot;
+			};
+
+			// The slots of a thread are marked dead when it exits
+			struct binding_list {
+				std::vector<binding> bindings;
+
+				~binding_list() {
+					for (auto& b : bindings) b.slot->alive.store(false, std::memory_order_release);
+				}
+			};
+
+			static inline thread_local binding_list t_list;
+
+			std::shared_ptr<char> m_token{ std::make_shared<char>() };
+		};
+
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_TICKER_HPP_
+#define _A_TICKER_HPP_
+
+#include "precise_sleep.hpp"
+#include "timing_stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace sw {
+
+	// What a ticker does when it falls behind by more than a period.
+	enum class missed_tick_policy {
+		catch_up,	// Every missed tick is delivered right away, one per wait() call, until the ticker is back on schedule.
+		skip		// The missed ticks are dropped, and the most recent one is delivered right away.
+	};
+
+	// Waits using std::this_thread::sleep_until(). Uses little CPU time, but wakes up as late as the OS decides to.
+	struct sleep_wait {
+		template <typename Clock, typename Duration>
+		void operator()(const std::chrono::time_point<Clock, Duration>& t) const {
+			std::this_thread::sleep_until(t);
+		}
+	};
+
+	// Waits by spinning on the clock. Wakes up on time, but keeps a CPU core busy.
+	struct spin_wait {
+		template <typename Clock, typename Duration>
+		void operator()(const std::chrono::time_point<Clock, Duration>& t) const noexcept {
+			while (Clock::now() < t) detail::cpu_relax();
+		}
+	};
+
+	// Waits using precise_sleep_until(), which sleeps most of the time and spins at the end. `spin_budget` is passed on to it.
+	struct hybrid_wait {
+		std::chrono::nanoseconds spin_budget = std::chrono::nanoseconds::max();
+
+		template <typename Clock, typename Duration>
+		void operator()(const std::chrono::time_point<Clock, Duration>& t) const {
+			if (spin_budget == std::chrono::nanoseconds::max()) precise_sleep_until(t);
+			else precise_sleep_until(t, std::chrono::ceil<typename Clock::duration>(spin_budget));
+		}
+	};
+
+	// Fixed-rate ticker. Tick n is due at exactly `epoch + n * period`, so unlike restarting a stopwatch in a loop, it doesn't drift no matter how late the individual wake-ups are. `WaitStrategy` is called with a time point to wait until.
+	template <typename MonotonicTrivialClock, typename WaitStrategy = hybrid_wait>
+	class basic_ticker {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+
+		// Creates a ticker with the given period. Its epoch is the current time, so the first tick is due one period from now.
+		template <typename Rep, typename Period>
+		explicit basic_ticker(std::chrono::duration<Rep, Period> period, missed_tick_policy policy = missed_tick_policy::skip, WaitStrategy wait = WaitStrategy{}) :
+			m_period{ std::max(std::chrono::ceil<duration>(period), duration{ 1 }) },
+			m_epoch{ clock::now() },
+			m_policy{ policy },
+			m_wait{ std::move(wait) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+		}
+
+		// Waits until the next tick is due. Returns the number of ticks that were skipped to get here, which can only be non-zero with missed_tick_policy::skip.
+		std::uint64_t wait() {
+			auto target = m_epoch + static_cast<typename duration::rep>(m_next) * m_period;
+			auto now	= clock::now();
+
+			std::uint64_t skipped{};
+
+			if (now < target) {
+				m_wait(target);
+				now = clock::now();
+			} else if (m_policy == missed_tick_policy::skip && now - target >= m_period) {
+				const auto latest = static_cast<std::uint64_t>((now - m_epoch) / m_period);
+
+				skipped		= latest - m_next;
+				m_next		= latest;
+				m_skipped	+= skipped;
+				target		= m_epoch + static_cast<typename duration::rep>(m_next) * m_period;
+			}
+
+			m_lateness.record(now - target);
+			m_next++;
+
+			return skipped;
+		}
+
+		// Moves the epoch to the current time and clears the statistics. The next tick is due one period from now.
+		void reset() noexcept {
+			m_epoch		= clock::now();
+			m_next		= 1;
+			m_skipped	= 0;
+			m_lateness.reset();
+		}
+
+		// Returns the time the next call to wait() waits for.
+		[[nodiscard]] time_point next_tick_time() const noexcept {
+			return m_epoch + static_cast<typename duration::rep>(m_next) * m_period;
+		}
+
+		// Returns the number of ticks delivered so far, including the ones skipped.
+		[[nodiscard]] std::uint64_t ticks() const noexcept {
+			return m_next - 1;
+		}
+
+		// Returns the number of ticks skipped so far.
+		[[nodiscard]] std::uint64_t skipped() const noexcept {
+			return m_skipped;
+		}
+
+		// Returns the statistics of how late each delivered tick was.
+		[[nodiscard]] const duration_accumulator& lateness() const noexcept {
+			return m_lateness;
+		}
+
+		// Returns the period.
+		[[nodiscard]] duration period() const noexcept {
+			return m_period;
+		}
+
+		// Returns the time of tick 0.
+		[[nodiscard]] time_point epoch() const noexcept {
+			return m_epoch;
+		}
+
+	private:
+
+		duration				m_period;
+		time_point				m_epoch;
+		missed_tick_policy		m_policy;
+		WaitStrategy			m_wait;
+		std::uint64_t			m_next{ 1 };
+		std::uint64_t			m_skipped{};
+		duration_accumulator	m_lateness;
+	};
+
+	// Fixed-rate ticker using std::chrono::steady_clock.
+	template <typename WaitStrategy = hybrid_wait>
+	using ticker = basic_ticker<std::chrono::steady_clock, WaitStrategy>;
+}
+
+#endif
\ No newline at end of file
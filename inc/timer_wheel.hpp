@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_TIMER_WHEEL_HPP_
+#define _A_TIMER_WHEEL_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace sw {
+
+	// Hierarchical hashed timer wheel for keeping track of a large number of deadlines. Scheduling and cancelling a timer is O(1), and expiry processing is amortized O(1) per tick and per timer. Deadlines are rounded up to whole ticks, so timers never expire early, but they can expire up to one tick late. Each timer carries a `Payload` which is handed back when it expires.
+	template <typename MonotonicTrivialClock, typename Payload>
+	class basic_timer_wheel {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using time_point	= typename clock::time_point;
+		using duration		= typename clock::duration;
+		using timer_id		= std::uint64_t;
+
+		// Creates an empty wheel. Tick 0 is at `origin`, and each tick is `tick` long.
+		explicit basic_timer_wheel(duration tick = std::chrono::duration_cast<duration>(std::chrono::milliseconds(1)), time_point origin = clock::now()) :
+			m_tick{ tick > duration::zero() ? tick : duration{ 1 } },
+			m_origin{ origin }
+		{
+			m_links.resize(slot_count);
+
+			for (std::uint32_t i{}; i < slot_count; i++) {
+				m_links[i].prev = m_links[i].next = i;
+			}
+		}
+
+		// Schedules a timer to expire at the given time. Returns an ID that can be used to cancel it.
+		timer_id schedule_at(time_point deadline, Payload payload) {
+			const auto index	= allocate(std::move(payload));
+			auto& node			= m_links[index];
+
+			node.expires = std::max(to_tick_ceil(deadline), m_current);
+			insert(index);
+			m_size++;
+
+			return (static_cast<timer_id>(node.generation) << 32) | index;
+		}
+
+		// Schedules a timer to expire after the given amount of time. Returns an ID that can be used to cancel it.
+		template <typename Rep, typename Period>
+		timer_id schedule_after(std::chrono::duration<Rep, Period> d, Payload payload) {
+			return schedule_at(clock::now() + std::chrono::ceil<duration>(d), std::move(payload));
+		}
+
+		// Cancels a timer. Returns false if the timer has already expired or been cancelled.
+		bool cancel(timer_id id) noexcept {
+			const auto index		= static_cast<std::uint32_t>(id);
+			const auto generation	= static_cast<std::uint32_t>(id >> 32);
+
+			if (index < slot_count || index >= m_links.size()) return false;
+
+			auto& node = m_links[index];
+
+			if (node.generation != generation || !node.active) return false;
+
+			unlink(index);
+			release(index);
+			m_size--;
+
+			return true;
+		}
+
+		// Processes every tick up to the given time, then calls `on_expired(Payload&)` for each expired timer in expiry order. The callback is free to schedule and cancel timers. Returns the number of expired timers.
+		template <typename Callback>
+		std::size_t advance(time_point now, Callback&& on_expired) {
+			m_batch.clear();
+
+			if (now < m_origin) return 0;
+
+			const auto target = to_tick_floor(now);
+
+			while (m_current <= target) {
+				if (m_size == 0) {
+					m_current = target + 1;
+					break;
+				}
+
+				process_tick();
+			}
+
+			for (auto& payload : m_batch) on_expired(payload);
+
+			return m_batch.size();
+		}
+
+		// Processes every tick up to the current time, then calls `on_expired(Payload&)` for each expired timer in expiry order. The callback is free to schedule and cancel timers. Returns the number of expired timers.
+		template <typename Callback>
+		std::size_t advance(Callback&& on_expired) {
+			return advance(clock::now(), std::forward<Callback>(on_expired));
+		}
+
+		// Preallocates space for the given number of timers.
+		void reserve(std::size_t timers) {
+			m_links.reserve(slot_count + timers);
+			m_payloads.reserve(timers);
+		}
+
+		// Returns the number of pending timers.
+		[[nodiscard]] std::size_t size() const noexcept {
+			return m_size;
+		}
+
+		// Indicates if there are no pending timers.
+		[[nodiscard]] bool empty() const noexcept {
+			return m_size == 0;
+		}
+
+		// Returns the length of a tick.
+		[[nodiscard]] duration tick() const noexcept {
+			return m_tick;
+		}
+
+	private:
+
+		// The first level has 256 slots, the other three have 64 each. Together they cover 2^26 ticks, which is more than 18 hours with 1 ms ticks. Timers further out than that are parked in the last slot and re-filed as the wheel turns.
+		static constexpr std::uint32_t	root_bits		= 8;
+		static constexpr std::uint32_t	level_bits		= 6;
+		static constexpr std::uint32_t	level_count		= 4;
+		static constexpr std::uint32_t	root_size		= 1u << root_bits;
+		static constexpr std::uint32_t	level_size		= 1u << level_bits;
+		static constexpr std::uint32_t	slot_count		= root_size + (level_count - 1) * level_size;
+		static constexpr std::uint64_t	max_range		= std::uint64_t{ 1 } << (root_bits + (level_count - 1) * level_bits);
+		static constexpr std::uint32_t	no_node			= ~std::uint32_t{};
+
+		// The first `slot_count` entries are the list heads of the slots, the rest are timers.
+		struct link {
+			std::uint64_t	expires{};
+			std::uint32_t	prev{ no_node };
+			std::uint32_t	next{ no_node };
+			std::uint32_t	generation{};
+			bool			active{};
+		};
+
+		duration				m_tick;
+		time_point				m_origin;
+		std::uint64_t			m_current{};
+		std::size_t				m_size{};
+		std::uint32_t			m_free{ no_node };
+		std::vector<link>		m_links;
+		std::vector<Payload>	m_payloads;
+		std::vector<Payload>	m_batch;
+
+		std::uint64_t to_tick_floor(time_point t) const noexcept {
+			return static_cast<std::uint64_t>((t - m_origin) / m_tick);
+		}
+
+		std::uint64_t to_tick_ceil(time_point t) const noexcept {
+			if (t <= m_origin) return 0;
+
+			const auto since	= t - m_origin;
+			const auto ticks	= static_cast<std::uint64_t>(since / m_tick);
+
+			return ticks + ((since % m_tick) != duration::zero() ? 1 : 0);
+		}
+
+		std::uint32_t allocate(Payload&& payload) {
+			std::uint32_t index{};
+
+			if (m_free != no_node) {
+				index	= m_free;
+				m_free	= m_links[index].next;
+				m_payloads[index - slot_count] = std::move(payload);
+			} else {
+				index = static_cast<std::uint32_t>(m_links.size());
+				m_links.emplace_back();
+				m_payloads.push_back(std::move(payload));
+			}
+
+			m_links[index].active = true;
+
+			return index;
+		}
+
+		void release(std::uint32_t index) noexcept {
+			auto& node = m_links[index];
+
+			node.active	= false;
+			node.generation++;
+			node.next	= m_free;
+			m_free		= index;
+		}
+
+		// Picks the slot based on how far in the future the timer expires.
+		std::uint32_t slot_of(std::uint64_t expires) const noexcept {
+			const auto delta = expires - m_current;
+
+			if (delta < root_size) return static_cast<std::uint32_t>(expires & (root_size - 1));
+
+			for (std::uint32_t level = 1; level < level_count; level++) {
+				const auto shift = root_bits + level * level_bits;
+
+				if (delta < (std::uint64_t{ 1 } << shift) || level == level_count - 1) {
+					if (delta >= max_range) expires = m_current + max_range - 1;
+
+					return root_size + (level - 1) * level_size + static_cast<std::uint32_t>((expires >> (shift - level_bits)) & (level_size - 1));
+				}
+			}
+
+			return 0; // Unreachable
+		}
+
+		void insert(std::uint32_t index) noexcept {
+			const auto head	= slot_of(m_links[index].expires);
+			const auto last	= m_links[head].prev;
+
+			m_links[index].prev	= last;
+			m_links[index].next	= head;
+			m_links[last].next	= index;
+			m_links[head].prev	= index;
+		}
+
+		void unlink(std::uint32_t index) noexcept {
+			auto& node = m_links[index];
+
+			m_links[node.prev].next = node.next;
+			m_links[node.next].prev = node.prev;
+		}
+
+		// Moves every timer of a slot down to the lower levels. Returns the index of the slot within its level.
+		std::uint32_t cascade(std::uint32_t level) noexcept {
+			const auto index	= static_cast<std::uint32_t>((m_current >> (root_bits + (level - 1) * level_bits)) & (level_size - 1));
+			const auto head		= root_size + (level - 1) * level_size + index;
+
+			auto node = m_links[head].next;
+			m_links[head].prev = m_links[head].next = head;
+
+			while (node != head) {
+				const auto next = m_links[node].next;
+				insert(node);
+				node = next;
+			}
+
+			return index;
+		}
+
+		void process_tick() {
+			const auto index = static_cast<std::uint32_t>(m_current & (root_size - 1));
+
+			if (index == 0) {
+				for (std::uint32_t level = 1; level < level_count && cascade(level) == 0; level++) {}
+			}
+
+			auto node = m_links[index].next;
+			m_links[index].prev = m_links[index].next = index;
+
+			while (node != index) {
+				const auto next = m_links[node].next;
+
+				m_batch.push_back(std::move(m_payloads[node - slot_count]));
+				release(node);
+				m_size--;
+
+				node = next;
+			}
+
+			m_current++;
+		}
+	};
+
+	// Timer wheel using std::chrono::steady_clock.
+	template <typename Payload>
+	using timer_wheel = basic_timer_wheel<std::chrono::steady_clock, Payload>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_TIMING_STATS_HPP_
+#define _A_TIMING_STATS_HPP_
+
+#include "stopwatch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace sw {
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Index of the highest set bit. `v` must not be 0.
+		inline int floor_log2(std::uint64_t v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+			return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index{};
+			_BitScanReverse64(&index, v);
+			return static_cast<int>(index);
+#else
+			int ret{};
+			while (v >>= 1) ret++;
+			return ret;
+#endif
+		}
+
+	}
+
+	// Running statistics of a series of durations. It stores a fixed amount of data no matter how many durations are recorded.
+	class duration_accumulator {
+	public:
+
+		// Adds a duration to the statistics.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d) noexcept {
+			const auto x = convert_time<d_nanoseconds>(d).count();
+
+			m_count++;
+			m_sum	+= x;
+			m_min	= std::min(m_min, x);
+			m_max	= std::max(m_max, x);
+
+			const auto delta = x - m_mean;
+			m_mean	+= delta / static_cast<double>(m_count);
+			m_m2	+= delta * (x - m_mean);
+		}
+
+		// Adds the statistics of another accumulator to this one, as if every duration recorded there was recorded here too.
+		void merge(const duration_accumulator& other) noexcept {
+			if (other.m_count == 0) return;
+
+			if (m_count == 0) {
+				*this = other;
+				return;
+			}
+
+			const auto count	= m_count + other.m_count;
+			const auto delta	= other.m_mean - m_mean;
+			const auto weight	= static_cast<double>(other.m_count) / static_cast<double>(count);
+
+			m_m2	+= other.m_m2 + delta * delta * static_cast<double>(m_count) * weight;
+			m_mean	+= delta * weight;
+			m_sum	+= other.m_sum;
+			m_min	= std::min(m_min, other.m_min);
+			m_max	= std::max(m_max, other.m_max);
+			m_count	= count;
+		}
+
+		// Clears the statistics.
+		void reset() noexcept {
+			*this = duration_accumulator();
+		}
+
+		// Returns the number of recorded durations.
+		[[nodiscard]] std::uint64_t count() const noexcept {
+			return m_count;
+		}
+
+		// Returns the sum of the recorded durations.
+		[[nodiscard]] d_nanoseconds sum() const noexcept {
+			return d_nanoseconds{ m_sum };
+		}
+
+		// Returns the shortest recorded duration, or zero if there are none.
+		[[nodiscard]] d_nanoseconds min() const noexcept {
+			return d_nanoseconds{ m_count ? m_min : 0.0 };
+		}
+
+		// Returns the longest recorded duration, or zero if there are none.
+		[[nodiscard]] d_nanoseconds max() const noexcept {
+			return d_nanoseconds{ m_count ? m_max : 0.0 };
+		}
+
+		// Returns the mean of the recorded durations, or zero if there are none.
+		[[nodiscard]] d_nanoseconds mean() const noexcept {
+			return d_nanoseconds{ m_mean };
+		}
+
+		// Returns the sample standard deviation of the recorded durations, or zero if there are fewer than two.
+		[[nodiscard]] d_nanoseconds stddev() const noexcept {
+			return d_nanoseconds{ m_count > 1 ? std::sqrt(m_m2 / static_cast<double>(m_count - 1)) : 0.0 };
+		}
+
+	private:
+
+		std::uint64_t	m_count{};
+		double			m_sum{};
+		double			m_min{ std::numeric_limits<double>::infinity() };
+		double			m_max{ -std::numeric_limits<double>::infinity() };
+		double			m_mean{};
+		double			m_m2{};
+	};
+
+	// Histogram of durations with log-linear buckets. Durations are recorded in whole nanoseconds; below 16 ns every value has its own bucket, and above that every power of two range is split into 16 buckets. This keeps the error of quantiles within 1/16 of the value, with a fixed number of buckets covering any duration.
+	class duration_histogram {
+	public:
+
+		static constexpr int			sub_bucket_bits	= 4;
+		static constexpr std::size_t	sub_buckets		= std::size_t{ 1 } << sub_bucket_bits;
+		static constexpr std::size_t	bucket_count	= sub_buckets + (64 - sub_bucket_bits) * sub_buckets;
+
+		// Adds a duration to the histogram `n` times. Negative durations count as 0.
+		template <typename Rep, typename Period>
+		void record(std::chrono::duration<Rep, Period> d, std::uint64_t n = 1) noexcept {
+			const auto ns = std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(), 0);
+
+			m_buckets[bucket_index(static_cast<std::uint64_t>(ns))] += n;
+			m_count	+= n;
+			m_sum	+= static_cast<double>(ns) * static_cast<double>(n);
+			m_min	= std::min(m_min, ns);
+			m_max	= std::max(m_max, ns);
+		}
+
+		// Adds the contents of another histogram to this one.
+		void merge(const duration_histogram& other) noexcept {
+			for (std::size_t i{}; i < bucket_count; i++) m_buckets[i] += other.m_buckets[i];
+
+			m_count	+= other.m_count;
+			m_sum	+= other.m_sum;
+			m_min	= std::min(m_min, other.m_min);
+			m_max	= std::max(m_max, other.m_max);
+		}
+
+		// Clears the histogram.
+		void reset() noexcept {
+			*this = duration_histogram();
+		}
+
+		// Returns the number of recorded durations.
+		[[nodiscard]] std::uint64_t count() const noexcept {
+			return m_count;
+		}
+
+		// Returns the sum of the recorded durations.
+		[[nodiscard]] d_nanoseconds sum() const noexcept {
+			return d_nanoseconds{ m_sum };
+		}
+
+		// Returns the mean of the recorded durations, or zero if there are none.
+		[[nodiscard]] d_nanoseconds mean() const noexcept {
+			return d_nanoseconds{ m_count ? m_sum / static_cast<double>(m_count) : 0.0 };
+		}
+
+		// Returns the shortest recorded duration, or zero if there are none.
+		[[nodiscard]] std::chrono::nanoseconds min() const noexcept {
+			return std::chrono::nanoseconds{ m_count ? m_min : 0 };
+		}
+
+		// Returns the longest recorded duration, or zero if there are none.
+		[[nodiscard]] std::chrono::nanoseconds max() const noexcept {
+			return std::chrono::nanoseconds{ m_count ? m_max : 0 };
+		}
+
+		// Returns an estimate of the duration at quantile `q` (0 to 1), such as 0.99 for the 99th percentile. Returns zero if the histogram is empty.
+		[[nodiscard]] std::chrono::nanoseconds quantile(double q) const noexcept {
+			if (m_count == 0) return std::chrono::nanoseconds::zero();
+
+			const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(m_count)));
+
+			// The extremes are known exactly
+			if (rank <= 1) return min();
+			if (rank >= m_count) return max();
+
+			std::uint64_t seen{};
+
+			for (std::size_t i{}; i < bucket_count; i++) {
+				seen += m_buckets[i];
+
+				if (seen >= rank) {
+					const auto mid = bucket_lower_bound(i) + (bucket_upper_bound(i) - bucket_lower_bound(i)) / 2;
+
+					return std::chrono::nanoseconds{ std::clamp<std::int64_t>(static_cast<std::int64_t>(mid), m_min, m_max) };
+				}
+			}
+
+			return max();
+		}
+
+		// Returns the number of durations in a bucket.
+		[[nodiscard]] std::uint64_t bucket(std::size_t index) const noexcept {
+			return m_buckets[index];
+		}
+
+		// Returns the bucket a duration of `ns` nanoseconds goes to.
+		[[nodiscard]] static constexpr std::size_t bucket_index(std::uint64_t ns) noexcept {
+			if (ns < sub_buckets) return static_cast<std::size_t>(ns);
+
+			const auto msb = static_cast<std::size_t>(detail::floor_log2(ns));
+
+			return sub_buckets + (msb - sub_bucket_bits) * sub_buckets + static_cast<std::size_t>((ns >> (msb - sub_bucket_bits)) & (sub_buckets - 1));
+		}
+
+		// Returns the smallest duration in nanoseconds that goes to a bucket.
+		[[nodiscard]] static constexpr std::uint64_t bucket_lower_bound(std::size_t index) noexcept {
+			if (index < sub_buckets) return index;
+
+			const auto shift = (index - sub_buckets) / sub_buckets;
+
+			return (sub_buckets + (index - sub_buckets) % sub_buckets) << shift;
+		}
+
+		// Returns the duration in nanoseconds right above the largest one that goes to a bucket.
+		[[nodiscard]] static constexpr std::uint64_t bucket_upper_bound(std::size_t index) noexcept {
+			if (index < sub_buckets) return index + 1;
+
+			return bucket_lower_bound(index) + (std::uint64_t{ 1 } << ((index - sub_buckets) / sub_buckets));
+		}
+
+	private:
+
+		std::array<std::uint64_t, bucket_count>	m_buckets{};
+		std::uint64_t							m_count{};
+		double									m_sum{};
+		std::int64_t							m_min{ std::numeric_limits<std::int64_t>::max() };
+		std::int64_t							m_max{};
+	};
+}
+
+#endif
\ No newline at end of file
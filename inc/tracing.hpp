@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_TRACING_HPP_
+#define _A_TRACING_HPP_
+
+#include "stopwatch.hpp"
+#include "thread_bindings.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace sw {
+
+	// Identifies a span, so that spans started from it, even on other threads, become its children. It's small and trivially copyable, so it can be passed along with the work it belongs to.
+	struct span_context {
+		std::uint64_t	trace_id{};		// Shared by every span of a request; 0 if there's no span
+		std::uint64_t	span_id{};
+		bool			sampled{};		// Whether the spans of the trace are recorded
+
+		// Indicates if the context belongs to a span.
+		[[nodiscard]] constexpr bool valid() const noexcept {
+			return trace_id != 0;
+		}
+	};
+
+	// A finished span, as passed to the sink of a tracer.
+	struct span_record {
+		const char*			name;
+		std::uint64_t		trace_id;
+		std::uint64_t		span_id;
+		std::uint64_t		parent_id;		// 0 for the root span of a trace
+		std::int64_t		start_ns;		// Since the epoch of the clock used for tracing
+		std::int64_t		duration_ns;
+		std::thread::id		thread;
+	};
+
+	// DO NOT USE! Internal helper utilities.
+	namespace detail {
+
+		// Random ids from a per-thread splitmix64 generator. 0 is skipped, since it means "no span".
+		inline std::uint64_t random_span_id() noexcept {
+			thread_local auto state = static_cast<std::uint64_t>(std::random_device{}()) << 32 ^ static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+			std::uint64_t ret{};
+
+			while (ret == 0) {
+				auto z	= (state += 0x9E3779B97F4A7C15);
+				z		= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+				z		= (z ^ (z >> 27)) * 0x94D049BB133111EB;
+				ret		= z ^ (z >> 31);
+			}
+
+			return ret;
+		}
+
+	}
+
+	// Records spans: timed sections that know which request they belong to and which span started them, so the timing of a request can be followed across threads. Whether a trace is recorded is decided when its root span starts (head sampling), and its other spans follow that decision; spans of traces that aren't sampled cost about as much as generating an id. Finished spans are collected per thread, and passed to a sink in batches.
+	template <typename MonotonicTrivialClock>
+	class basic_tracer {
+	public:
+		using clock		= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using sink_type	= std::function<void(const std::vector<span_record>&)>;
+
+		// A span from its creation until it ends, timed with a stopwatch.
+		class span {
+		public:
+			span(const span&)				= delete;
+			span& operator=(const span&)	= delete;
+
+			// Ends the span, unless it was ended already.
+			~span() {
+				end();
+			}
+
+			// Ends the span, and hands it to the tracer if it's sampled. Calling it again does nothing.
+			void end() {
+				if (m_ended) return;
+
+				m_ended = true;
+
+				if (m_context.sampled) m_tracer->finish({ m_name, m_context.trace_id, m_context.span_id, m_parent_id, m_start_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(m_timer.get_elapsed()).count(), std::this_thread::get_id() });
+			}
+
+			// Starts a child span of this one on the calling thread.
+			[[nodiscard]] span child(const char* name) {
+				return m_tracer->start_span(name, m_context);
+			}
+
+			// Returns the context of the span, for starting children of it on other threads.
+			[[nodiscard]] const span_context& context() const noexcept {
+				return m_context;
+			}
+
+			// Indicates if the span is recorded.
+			[[nodiscard]] bool is_sampled() const noexcept {
+				return m_context.sampled;
+			}
+
+			// Returns the stopwatch timing the span. Pausing it leaves the paused time out of the duration of the span. It only runs if the span is sampled.
+			[[nodiscard]] basic_stopwatch<clock>& timer() noexcept {
+				return m_timer;
+			}
+
+		private:
+			friend class basic_tracer;
+
+			span(basic_tracer& tracer, const char* name, const span_context& context, std::uint64_t parent_id) noexcept :
+				m_tracer{ &tracer },
+				m_name{ name },
+				m_context{ context },
+				m_parent_id{ parent_id }
+			{
+				if (!m_context.sampled) return;
+
+				m_start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+				m_timer.start();
+			}
+
+			basic_tracer*			m_tracer;
+			const char*				m_name;
+			span_context			m_context;
+			std::uint64_t			m_parent_id;
+			std::int64_t			m_start_ns{};
+			basic_stopwatch<clock>	m_timer;
+			bool					m_ended{};
+		};
+
+		// Creates a tracer that records `sample_rate` (0 to 1) of the traces, and passes the finished spans to `sink` in batches of `batch_size`. The sink is called by the thread that fills a batch, or by flush(), but never by two threads at once.
+		explicit basic_tracer(sink_type sink, double sample_rate = 1.0, std::size_t batch_size = 256) :
+			m_sink{ std::move(sink) },
+			m_sample_rate{ std::clamp(sample_rate, 0.0, 1.0) },
+			m_batch_size{ std::max<std::size_t>(batch_size, 1) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			// The decision is a function of the trace id, so it's the same wherever it's made
+			m_threshold = m_sample_rate >= 1.0 ? std::numeric_limits<std::uint64_t>::max() : static_cast<std::uint64_t>(m_sample_rate * 18446744073709551616.0);
+		}
+
+		// Passes the spans that weren't exported yet to the sink.
+		~basic_tracer() {
+			flush();
+		}
+
+		basic_tracer(const basic_tracer&)				= delete;
+		basic_tracer& operator=(const basic_tracer&)	= delete;
+
+		// Starts the root span of a new trace, and decides if the trace is sampled. `name` must stay valid until the span is exported, like a string literal does.
+		[[nodiscard]] span start_span(const char* name) {
+			const auto trace_id = detail::random_span_id();
+			const auto sampled	= m_sample_rate >= 1.0 || trace_id < m_threshold;
+
+			return span(*this, name, { trace_id, detail::random_span_id(), sampled }, 0);
+		}
+
+		// Starts a child span of the span `parent` belongs to, which can be on another thread. It's sampled if the parent is. Starts a root span if `parent` isn't valid.
+		[[nodiscard]] span start_span(const char* name, const span_context& parent) {
+			if (!parent.valid()) return start_span(name);
+
+			return span(*this, name, { parent.trace_id, detail::random_span_id(), parent.sampled }, parent.span_id);
+		}
+
+		// Passes the finished spans of every thread that weren't exported yet to the sink.
+		void flush() {
+			auto spans = std::vector<span_record>();
+
+			{
+				std::lock_guard<std::mutex> lock(m_buffers_mutex);
+
+				// Threads that exited are dropped once their spans are taken. They're checked before taking the spans, so the last spans of a thread that's exiting meanwhile aren't lost
+				m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [&](const auto& b) {
+					const auto dead = !b->alive.load(std::memory_order_acquire);
+
+					std::lock_guard<std::mutex> buffer_lock(b->mutex);
+
+					spans.insert(spans.end(), b->spans.begin(), b->spans.end());
+					b->spans.clear();
+
+					return dead;
+				}), m_buffers.end());
+			}
+
+			export_spans(spans);
+		}
+
+		// Returns the fraction of traces that are sampled.
+		[[nodiscard]] double sample_rate() const noexcept {
+			return m_sample_rate;
+		}
+
+		// Returns the number of spans passed to the sink so far.
+		[[nodiscard]] std::uint64_t exported() const noexcept {
+			return m_exported.load(std::memory_order_relaxed);
+		}
+
+	private:
+
+		// The finished spans of a thread. Its mutex is only contended while flushing.
+		struct thread_buffer {
+			std::mutex					mutex;
+			std::vector<span_record>	spans;
+			std::atomic<bool>			alive{ true };
+		};
+
+		sink_type									m_sink;
+		double										m_sample_rate;
+		std::uint64_t								m_threshold{};
+		std::size_t									m_batch_size;
+
+		std::mutex									m_buffers_mutex;
+		std::vector<std::shared_ptr<thread_buffer>>	m_buffers;
+		std::mutex									m_sink_mutex;
+		std::atomic<std::uint64_t>					m_exported{};
+
+		// The buffers of threads that exited are freed by the next flush
+		detail::thread_bindings<thread_buffer>		m_bindings;
+
+		void finish(const span_record& record) {
+			auto& buffer	= this_thread_buffer();
+			auto batch		= std::vector<span_record>();
+
+			{
+				std::lock_guard<std::mutex> lock(buffer.mutex);
+
+				if (buffer.spans.capacity() == 0) buffer.spans.reserve(m_batch_size);
+
+				buffer.spans.push_back(record);
+
+				if (buffer.spans.size() < m_batch_size) return;
+
+				batch.swap(buffer.spans);
+			}
+
+			export_spans(batch);
+		}
+
+		void export_spans(const std::vector<span_record>& spans) {
+			if (spans.empty()) return;
+
+			std::lock_guard<std::mutex> lock(m_sink_mutex);
+
+			m_sink(spans);
+			m_exported.fetch_add(spans.size(), std::memory_order_relaxed);
+		}
+
+		thread_buffer& this_thread_buffer() {
+			if (auto* buffer = m_bindings.find()) return *buffer;
+
+			auto buffer = std::make_shared<thread_buffer>();
+
+			{
+				std::lock_guard<std::mutex> lock(m_buffers_mutex);
+				m_buffers.push_back(buffer);
+			}
+
+			m_bindings.bind(buffer);
+
+			return *buffer;
+		}
+	};
+
+	// Tracer using std::chrono::steady_clock.
+	using tracer = basic_tracer<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2021 Adam D.
+ * Distributed under the MIT license.
+ * See accompanying file "LICENSE" or a copy at https://mit-license.org/
+ */
+
+#ifndef _A_WATCHDOG_HPP_
+#define _A_WATCHDOG_HPP_
+
+#include "stopwatch.hpp"
+#include "thread_bindings.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sw {
+
+	// Reported by a watchdog when a timed section runs longer than its threshold.
+	struct watchdog_event {
+		const char*					name;
+		std::chrono::nanoseconds	elapsed;	// How long the section had been running when it was noticed
+		std::chrono::nanoseconds	threshold;
+		std::thread::id				thread;
+	};
+
+	// Notices timed sections that run too long while they're still running. Each thread publishes its active sections in its own slot, which a background thread scans periodically. A section that's over its threshold is reported to a callback once.
+	template <typename MonotonicTrivialClock>
+	class basic_watchdog {
+	public:
+		using clock			= std::enable_if_t<detail::is_trivial_clock_v<MonotonicTrivialClock>, MonotonicTrivialClock>;
+		using duration		= typename clock::duration;
+		using callback_type	= std::function<void(const watchdog_event&)>;
+
+		// The number of nested sections watched per thread. Sections nested deeper than this are not watched.
+		static constexpr std::size_t max_depth = 8;
+
+	private:
+
+		// The seqlock of an entry is odd while a section is active. Entering a section writes the fields and then makes it odd, leaving makes it even.
+		struct entry {
+			std::atomic<std::uint64_t>		seq{};
+			std::atomic<const char*>		name{};
+			std::atomic<std::int64_t>		start{};
+			std::atomic<std::int64_t>		threshold{};
+			std::uint64_t					reported{};	// Only accessed by the scanning thread
+		};
+
+		struct thread_slot {
+			std::array<entry, max_depth>	entries;
+			std::size_t						depth{};	// Only accessed by the owner thread
+			std::thread::id					thread{ std::this_thread::get_id() };
+			std::atomic<bool>				alive{ true };
+		};
+
+	public:
+
+		// A section watched by a watchdog, from its creation to its destruction.
+		class scope {
+		public:
+			scope(const scope&)				= delete;
+			scope& operator=(const scope&)	= delete;
+
+			~scope() {
+				if (m_entry) m_entry->seq.store(m_entry->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+				m_slot->depth--;
+			}
+
+			// Returns how long the section has been running.
+			[[nodiscard]] duration get_elapsed() const noexcept {
+				return clock::now() - m_start;
+			}
+
+		private:
+			friend class basic_watchdog;
+
+			scope(thread_slot* slot, const char* name, std::int64_t threshold_ns) noexcept :
+				m_slot{ slot },
+				m_start{ clock::now() }
+			{
+				const auto depth = slot->depth++;
+
+				if (depth >= max_depth) return;
+
+				m_entry = &slot->entries[depth];
+
+				// Orders these stores after the end of the previous section in this entry, for the scanner
+				std::atomic_thread_fence(std::memory_order_release);
+
+				m_entry->name.store(name, std::memory_order_relaxed);
+				m_entry->start.store(to_ns(m_start), std::memory_order_relaxed);
+				m_entry->threshold.store(threshold_ns, std::memory_order_relaxed);
+				m_entry->seq.store(m_entry->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			}
+
+			thread_slot*					m_slot;
+			entry*							m_entry{};
+			typename clock::time_point		m_start;
+		};
+
+		// Creates a watchdog that scans the sections every `scan_interval` on a background thread, and reports the ones over their threshold to `callback`. The callback is called on the background thread. With a zero interval, there's no background thread, and scan() has to be called instead.
+		template <typename Rep, typename Period>
+		basic_watchdog(std::chrono::duration<Rep, Period> scan_interval, callback_type callback) :
+			m_callback{ std::move(callback) }
+		{
+			static_assert(clock::is_steady, "Only monotonic clocks can be used");
+
+			if (scan_interval > scan_interval.zero()) {
+				m_thread = std::thread([this, interval = std::chrono::ceil<std::chrono::nanoseconds>(scan_interval)] {
+					std::unique_lock<std::mutex> lock(m_stop_mutex);
+
+					while (!m_cv.wait_for(lock, interval, [&] { return m_stop; })) {
+						lock.unlock();
+						scan();
+						lock.lock();
+					}
+				});
+			}
+		}
+
+		// Stops the background thread.
+		~basic_watchdog() {
+			{
+				std::lock_guard<std::mutex> lock(m_stop_mutex);
+				m_stop = true;
+			}
+
+			m_cv.notify_all();
+
+			if (m_thread.joinable()) m_thread.join();
+		}
+
+		basic_watchdog(const basic_watchdog&)				= delete;
+		basic_watchdog& operator=(const basic_watchdog&)	= delete;
+
+		// Watches a section until the returned scope is destroyed. `name` must stay valid for the lifetime of the watchdog, like a string literal does. The first section on a thread registers the thread, after that it's a clock read and a few stores.
+		template <typename Rep, typename Period>
+		[[nodiscard]] scope watch(const char* name, std::chrono::duration<Rep, Period> threshold) {
+			return scope(this_thread_slot(), name, std::chrono::ceil<std::chrono::nanoseconds>(threshold).count());
+		}
+
+		// Scans the sections once, and reports the ones over their threshold that weren't reported yet. Returns the number of sections reported.
+		std::size_t scan() {
+			std::lock_guard<std::mutex> scan_lock(m_scan_mutex);
+
+			auto events	= std::vector<watchdog_event>();
+			auto now	= to_ns(clock::now());
+
+			{
+				std::lock_guard<std::mutex> lock(m_slots_mutex);
+
+				// Threads that exited are dropped
+				m_slots.erase(std::remove_if(m_slots.begin(), m_slots.end(), [](const auto& s) { return !s->alive.load(std::memory_order_acquire); }), m_slots.end());
+
+				for (const auto& slot : m_slots) {
+					for (auto& e : slot->entries) {
+						const auto seq = e.seq.load(std::memory_order_acquire);
+
+						if (seq % 2 == 0 || seq == e.reported) continue;
+
+						const auto name			= e.name.load(std::memory_order_relaxed);
+						const auto start		= e.start.load(std::memory_order_relaxed);
+						const auto threshold	= e.threshold.load(std::memory_order_relaxed);
+
+						std::atomic_thread_fence(std::memory_order_acquire);
+
+						// The section ended or was replaced while reading it
+						if (e.seq.load(std::memory_order_relaxed) != seq) continue;
+
+						if (now - start <= threshold) continue;
+
+						e.reported = seq;
+						events.push_back({ name, std::chrono::nanoseconds(now - start), std::chrono::nanoseconds(threshold), slot->thread });
+					}
+				}
+			}
+
+			for (const auto& event : events) m_callback(event);
+
+			return events.size();
+		}
+
+		// Returns the number of threads that have watched sections and are still running, as of the last scan.
+		[[nodiscard]] std::size_t threads() const {
+			std::lock_guard<std::mutex> lock(m_slots_mutex);
+			return m_slots.size();
+		}
+
+	private:
+
+		callback_type								m_callback;
+
+		mutable std::mutex							m_slots_mutex;
+		std::vector<std::shared_ptr<thread_slot>>	m_slots;
+		std::mutex									m_scan_mutex;
+
+		std::mutex									m_stop_mutex;
+		std::condition_variable						m_cv;
+		bool										m_stop{};
+		std::thread									m_thread;
+
+		// The slots of threads that exit are marked dead, and freed by the next scan
+		detail::thread_bindings<thread_slot>		m_bindings;
+
+		thread_slot* this_thread_slot() {
+			if (auto* slot = m_bindings.find()) return slot;
+
+			auto slot = std::make_shared<thread_slot>();
+
+			{
+				std::lock_guard<std::mutex> lock(m_slots_mutex);
+				m_slots.push_back(slot);
+			}
+
+			m_bindings.bind(slot);
+
+			return slot.get();
+		}
+
+		static std::int64_t to_ns(const typename clock::time_point& t) noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+		}
+	};
+
+	// Watchdog using std::chrono::steady_clock.
+	using watchdog = basic_watchdog<std::chrono::steady_clock>;
+}
+
+#endif
\ No newline at end of file
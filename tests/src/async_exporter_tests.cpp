@@ -0,0 +1,243 @@
+#include "catch.hpp"
+
+#include "async_exporter.hpp"
+#include "manual_clock.hpp"
+
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+using test_async_exporter = sw::basic_async_exporter<sw::manual_clock>;
+
+static const char* const record_names[] = { "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9" };
+
+// Keeps a copy of every batch, since the exporter reuses them.
+struct batch_collector {
+	std::vector<sw::export_batch> batches;
+
+	auto sink() {
+		return [this](const sw::export_batch& b) { batches.push_back(b); };
+	}
+};
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Async exporter batches and summarizes records") {
+	sw::manual_clock::reset();
+
+	auto collector	= batch_collector();
+	auto exporter	= test_async_exporter(0ms, collector.sink());
+
+	const auto start = sw::manual_clock::now();
+
+	exporter.record("parse", start, 10ms);
+	exporter.record("render", start + 10ms, 30ms);
+	exporter.record("parse", start + 40ms, 20ms);
+
+	// Nothing is exported until a flush
+	REQUIRE(collector.batches.empty());
+	REQUIRE(exporter.flush() == 3);
+	REQUIRE(collector.batches.size() == 1);
+
+	const auto& batch = collector.batches[0];
+
+	REQUIRE(batch.lost == 0);
+	REQUIRE(batch.records.size() == 3);
+	REQUIRE(std::string(batch.records[0].name) == "parse");
+	REQUIRE(batch.records[1].start_ns == std::chrono::nanoseconds(start.time_since_epoch() + 10ms).count());
+	REQUIRE(batch.records[1].duration_ns == std::chrono::nanoseconds(30ms).count());
+	REQUIRE(batch.records[2].thread == 0);
+
+	REQUIRE(batch.summaries.size() == 2);
+	REQUIRE(std::string(batch.summaries[0].name) == "parse");
+	REQUIRE(batch.summaries[0].durations.count() == 2);
+	REQUIRE(batch.summaries[0].durations.max() == 20ms);
+	REQUIRE(std::string(batch.summaries[1].name) == "render");
+	REQUIRE(batch.summaries[1].durations.count() == 1);
+
+	// Empty batches are skipped
+	REQUIRE(exporter.flush() == 0);
+	REQUIRE(collector.batches.size() == 1);
+	REQUIRE(exporter.exported() == 3);
+}
+
+TEST_CASE("Async exporter summarizes names by content") {
+	sw::manual_clock::reset();
+
+	auto collector	= batch_collector();
+	auto exporter	= test_async_exporter(0ms, collector.sink());
+
+	const char a[] = "same";
+	const char b[] = "same";
+
+	exporter.record(a, sw::manual_clock::now(), 1ms);
+	exporter.record(b, sw::manual_clock::now(), 2ms);
+	exporter.flush();
+
+	REQUIRE(collector.batches[0].summaries.size() == 1);
+	REQUIRE(collector.batches[0].summaries[0].durations.count() == 2);
+}
+
+TEST_CASE("Async exporter scope records the running time of its stopwatch") {
+	sw::manual_clock::reset();
+
+	auto collector	= batch_collector();
+	auto exporter	= test_async_exporter(0ms, collector.sink());
+
+	const auto start = sw::manual_clock::now();
+
+	{
+		auto t = exporter.trace("section");
+
+		sw::manual_clock::advance(5ms);
+		t.timer().pause();
+		sw::manual_clock::advance(100ms);
+		t.timer().start();
+		sw::manual_clock::advance(5ms);
+	}
+
+	exporter.flush();
+
+	const auto& r = collector.batches[0].records[0];
+
+	REQUIRE(std::string(r.name) == "section");
+	REQUIRE(r.duration_ns == std::chrono::nanoseconds(10ms).count());
+	REQUIRE(r.start_ns == std::chrono::nanoseconds(start.time_since_epoch() + 100ms).count());
+}
+
+TEST_CASE("Async exporter backpressure policies") {
+	sw::manual_clock::reset();
+
+	SECTION("Drop keeps the oldest records") {
+		auto collector	= batch_collector();
+		auto exporter	= test_async_exporter(0ms, collector.sink(), sw::backpressure::drop, 4);
+
+		for (auto name : record_names) exporter.record(name, sw::manual_clock::now(), 1ms);
+
+		REQUIRE(exporter.flush() == 4);
+		REQUIRE(collector.batches[0].lost == 6);
+		REQUIRE(std::string(collector.batches[0].records[0].name) == "r0");
+		REQUIRE(std::string(collector.batches[0].records[3].name) == "r3");
+
+		// There's room again after a flush
+		exporter.record("after", sw::manual_clock::now(), 1ms);
+
+		REQUIRE(exporter.flush() == 1);
+		REQUIRE(collector.batches[1].lost == 0);
+		REQUIRE(exporter.lost() == 6);
+	}
+
+	SECTION("Overwrite keeps the newest records") {
+		auto collector	= batch_collector();
+		auto exporter	= test_async_exporter(0ms, collector.sink(), sw::backpressure::overwrite, 4);
+
+		for (auto name : record_names) exporter.record(name, sw::manual_clock::now(), 1ms);
+
+		REQUIRE(exporter.flush() == 4);
+		REQUIRE(collector.batches[0].lost == 6);
+		REQUIRE(std::string(collector.batches[0].records[0].name) == "r6");
+		REQUIRE(std::string(collector.batches[0].records[3].name) == "r9");
+	}
+
+	SECTION("Capacity is rounded up to a power of two") {
+		auto exporter = test_async_exporter(0ms, [](const sw::export_batch&) {}, sw::backpressure::drop, 5);
+
+		REQUIRE(exporter.capacity() == 8);
+		REQUIRE(exporter.policy() == sw::backpressure::drop);
+	}
+
+	SECTION("Block needs a background thread") {
+		REQUIRE_THROWS_AS(test_async_exporter(0ms, [](const sw::export_batch&) {}, sw::backpressure::block), std::invalid_argument);
+	}
+}
+
+TEST_CASE("Async exporter blocks until the background thread makes room") {
+	constexpr int count = 2000;
+
+	auto collector = batch_collector();
+
+	{
+		auto exporter = sw::async_exporter(1h, collector.sink(), sw::backpressure::block, 8);
+
+		for (int i{}; i < count; i++) exporter.record("blocking", std::chrono::steady_clock::now(), 1us);
+	}
+
+	std::size_t records{};
+	std::uint64_t lost{};
+
+	for (const auto& b : collector.batches) {
+		records	+= b.records.size();
+		lost	+= b.lost;
+	}
+
+	REQUIRE(records == count);
+	REQUIRE(lost == 0);
+
+	// The background thread was woken up early, long before the hour passed
+	REQUIRE(collector.batches.size() > 1);
+}
+
+TEST_CASE("Async exporter collects records from every thread") {
+	constexpr int threads	= 4;
+	constexpr int count		= 1000;
+
+	auto collector = batch_collector();
+
+	{
+		auto exporter	= sw::async_exporter(1ms, collector.sink(), sw::backpressure::block, 64);
+		auto workers	= std::vector<std::thread>();
+
+		for (int t{}; t < threads; t++) {
+			workers.emplace_back([&] {
+				for (int i{}; i < count; i++) exporter.record("worker", std::chrono::steady_clock::now(), 1us);
+			});
+		}
+
+		for (auto& w : workers) w.join();
+	}
+
+	auto ids			= std::set<std::uint32_t>();
+	std::size_t records	{};
+
+	for (const auto& b : collector.batches) {
+		records += b.records.size();
+		for (const auto& r : b.records) ids.insert(r.thread);
+	}
+
+	REQUIRE(records == threads * count);
+	REQUIRE(ids.size() == threads);
+}
+
+TEST_CASE("Async exporter writes to a file") {
+	sw::manual_clock::reset();
+
+	auto file = std::tmpfile();
+	REQUIRE(file != nullptr);
+
+	{
+		auto exporter = test_async_exporter(0ms, sw::file_export_sink(file), sw::backpressure::drop, 2);
+
+		exporter.record("a", sw::manual_clock::now(), 5ns);
+		exporter.record("b", sw::manual_clock::now(), 7ns);
+		exporter.record("c", sw::manual_clock::now(), 9ns);
+	}
+
+	std::rewind(file);
+
+	const auto ns = std::to_string(std::chrono::nanoseconds(sw::manual_clock::now().time_since_epoch()).count());
+
+	char buffer[256]{};
+	const auto size = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+	std::fclose(file);
+
+	REQUIRE(std::string(buffer, size) == "a\t0\t" + ns + "\t5\nb\t0\t" + ns + "\t7\n# lost\t1\n");
+}
\ No newline at end of file
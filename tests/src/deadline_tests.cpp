@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include "deadline.hpp"
+#include "manual_clock.hpp"
+
+using namespace std::literals::chrono_literals;
+
+using test_deadline = sw::basic_deadline<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("deadline expires within the tolerance") {
+	sw::manual_clock::reset();
+
+	auto d = test_deadline(5ms, 20us);
+	int iterations{};
+
+	// Each iteration takes 1 us
+	while (!d.expired()) {
+		sw::manual_clock::advance(1us);
+		iterations++;
+	}
+
+	REQUIRE(d.get_elapsed() >= 5ms);
+	REQUIRE(d.get_elapsed() <= 5ms + 20us);
+	REQUIRE(d.check_interval() > 10);
+	REQUIRE(d.check_interval() <= 20);
+	REQUIRE(d.expired());
+	REQUIRE(d.remaining() == 0ms);
+}
+
+TEST_CASE("deadline adapts to slower iterations") {
+	sw::manual_clock::reset();
+
+	auto d = test_deadline(10ms, 50us);
+
+	for (int i{}; i < 1000; i++) {
+		REQUIRE(!d.expired());
+		sw::manual_clock::advance(1us);
+	}
+
+	REQUIRE(d.check_interval() > 25);
+
+	// Iterations suddenly get 10x slower
+	while (!d.expired()) sw::manual_clock::advance(10us);
+
+	REQUIRE(d.get_elapsed() <= 10ms + 2 * 50us);
+	REQUIRE(d.check_interval() <= 10);
+}
+
+TEST_CASE("deadline remaining(), expired_now() and reset()") {
+	sw::manual_clock::reset();
+
+	auto d = test_deadline(1s);
+
+	REQUIRE(d.budget() == 1s);
+	REQUIRE(d.remaining() == 1s);
+
+	sw::manual_clock::advance(300ms);
+
+	REQUIRE(d.remaining() == 700ms);
+	REQUIRE(!d.expired_now());
+
+	auto child = test_deadline(d.remaining() / 2);
+
+	sw::manual_clock::advance(700ms);
+
+	REQUIRE(child.expired_now());
+	REQUIRE(d.expired_now());
+
+	d.reset(1ms, 1us);
+
+	REQUIRE(!d.expired_now());
+	REQUIRE(d.remaining() == 1ms);
+
+	d.reset(0ms, 1us);
+
+	REQUIRE(d.expired());
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+
+#include "fixed_timestep.hpp"
+#include "manual_clock.hpp"
+
+using namespace std::literals::chrono_literals;
+
+using test_timestep = sw::basic_fixed_timestep<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("fixed_timestep accumulates frame time") {
+	sw::manual_clock::reset();
+
+	auto stepper = test_timestep(10ms);
+
+	REQUIRE(stepper.advance() == 0);
+
+	sw::manual_clock::advance(25ms);
+
+	REQUIRE(stepper.advance() == 2);
+	REQUIRE(stepper.accumulated() == 5ms);
+	REQUIRE(stepper.alpha() == Approx(0.5));
+
+	sw::manual_clock::advance(4ms);
+
+	REQUIRE(stepper.advance() == 0);
+	REQUIRE(stepper.alpha() == Approx(0.9));
+
+	sw::manual_clock::advance(1ms);
+
+	int updates{};
+	REQUIRE(stepper.frame([&](auto step) { REQUIRE(step == 10ms); updates++; }) == 1);
+	REQUIRE(updates == 1);
+	REQUIRE(stepper.alpha() == 0.0);
+	REQUIRE(stepper.total_steps() == 3);
+	REQUIRE(stepper.frame_times().count() == 3);
+	REQUIRE(stepper.frame_times().max() == 25ms);
+	REQUIRE(stepper.frame_times().sum() == 30ms);
+}
+
+TEST_CASE("fixed_timestep caps the number of steps per frame") {
+	sw::manual_clock::reset();
+
+	auto stepper = test_timestep(10ms, 4);
+
+	stepper.advance();
+	sw::manual_clock::advance(1s + 3ms);
+
+	REQUIRE(stepper.advance() == 4);
+	REQUIRE(stepper.dropped() == 960ms);
+	REQUIRE(stepper.accumulated() == 3ms);
+
+	stepper.reset();
+
+	REQUIRE(stepper.advance() == 0);
+	REQUIRE(stepper.dropped() == 0ms);
+	REQUIRE(stepper.total_steps() == 0);
+	REQUIRE(stepper.frame_times().count() == 0);
+}
\ No newline at end of file
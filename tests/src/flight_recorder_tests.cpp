@@ -0,0 +1,291 @@
+#include "catch.hpp"
+
+#include "flight_recorder.hpp"
+#include "manual_clock.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals::chrono_literals;
+
+using test_flight_recorder = sw::basic_flight_recorder<sw::manual_clock>;
+
+static const std::string recording_path = "flight_recorder_tests.bin";
+
+static std::int64_t manual_ns(sw::manual_clock::time_point t) {
+	return t.time_since_epoch().count();
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Flight recorder events are read back") {
+	sw::manual_clock::reset();
+
+	const auto t0 = sw::manual_clock::now();
+
+	{
+		auto recorder = test_flight_recorder(recording_path, 16);
+
+		recorder.record("second", t0 + 2ms, 1ms);
+		recorder.record("first", t0, 5ms);
+		recorder.record("a name that is too long to fit into a record", t0 + 3ms, 0ns);
+
+		REQUIRE(recorder.recorded() == 3);
+		REQUIRE(recorder.capacity() == 16);
+	}
+
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.recorded == 3);
+	REQUIRE(r.events.size() == 3);
+
+	// Sorted by start time
+	REQUIRE(r.events[0].name == "first");
+	REQUIRE(r.events[0].start_ns == manual_ns(t0));
+	REQUIRE(r.events[0].duration_ns == 5'000'000);
+	REQUIRE(r.events[0].sequence == 1);
+	REQUIRE(r.events[1].name == "second");
+	REQUIRE(r.events[2].name == "a name that is too long to fit ");
+	REQUIRE(r.events[0].thread == r.events[1].thread);
+
+	REQUIRE(r.clock_anchor_ns == manual_ns(t0));
+	REQUIRE(r.to_system_ns(manual_ns(t0) + 1000) == r.system_anchor_ns + 1000);
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Flight recorder keeps the last events") {
+	sw::manual_clock::reset();
+
+	{
+		auto recorder = test_flight_recorder(recording_path, 4);
+
+		for (int i{}; i < 10; i++) recorder.record("event", sw::manual_clock::now() + i * 1ms, 1ms);
+	}
+
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.recorded == 10);
+	REQUIRE(r.events.size() == 4);
+
+	for (std::size_t i{}; i < 4; i++) REQUIRE(r.events[i].sequence == 6 + i);
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Flight recorder records are never mixed by threads sharing them") {
+	constexpr int threads	= 8;
+	constexpr int reads		= 500;
+
+	auto recorder	= sw::flight_recorder(recording_path, 2);
+	auto workers	= std::vector<std::thread>();
+	auto stop		= std::atomic<bool>();
+
+	// Every field of an event is derived from the same value, so a record written by two threads at once would show
+	for (int t{}; t < threads; t++) {
+		workers.emplace_back([&recorder, &stop, t] {
+			static const char* const names[] = { "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7" };
+
+			for (std::int64_t i{}; !stop; i = (i + 1) % 1'000'000) {
+				const auto ns = std::chrono::nanoseconds(t * 1'000'000 + i);
+
+				recorder.record(names[t], std::chrono::steady_clock::time_point(ns), ns);
+			}
+		});
+	}
+
+	// The file is read while it's being written, since that's when a mixed record could be seen
+	std::size_t mixed{};
+
+	while (recorder.recorded() < 1000) std::this_thread::yield();
+
+	for (int i{}; i < reads; i++) {
+		for (const auto& e : sw::read_flight_recording(recording_path).events) {
+			if (e.start_ns != e.duration_ns || e.name != "t" + std::to_string(e.start_ns / 1'000'000)) mixed++;
+		}
+	}
+
+	stop = true;
+
+	for (auto& w : workers) w.join();
+
+	REQUIRE(mixed == 0);
+
+	// Once every thread is done, every record is complete
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 2);
+
+	for (const auto& e : r.events) REQUIRE(e.start_ns == e.duration_ns);
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Flight recorder drops events whose record is taken") {
+	sw::manual_clock::reset();
+
+	auto recorder = test_flight_recorder(recording_path, 2);
+
+	// Sets the sequence number of the first record, as another thread would
+	const auto set_first_sequence = [](std::uint64_t sequence) {
+		auto file = std::fstream(recording_path, std::ios::in | std::ios::out | std::ios::binary);
+
+		file.seekp(sizeof(sw::detail::flight_header) + offsetof(sw::detail::flight_record, sequence));
+		file.write(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+	};
+
+	recorder.record("a", sw::manual_clock::now(), 1ms);
+	recorder.record("b", sw::manual_clock::now(), 1ms);
+
+	// The first record is still being written by a thread that the ring has lapped
+	set_first_sequence(0);
+	recorder.record("c", sw::manual_clock::now(), 1ms);
+
+	auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.recorded == 3);
+	REQUIRE(r.events.size() == 1);
+	REQUIRE(r.events[0].name == "b");
+
+	// The first record already holds a newer event
+	set_first_sequence(7);
+	recorder.record("d", sw::manual_clock::now(), 1ms);
+	recorder.record("e", sw::manual_clock::now(), 1ms);
+
+	r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 2);
+	REQUIRE(r.events[0].sequence == 3);
+	REQUIRE(r.events[0].name == "d");
+	REQUIRE(r.events[1].sequence == 6);
+
+	// An older finished record is taken as usual
+	set_first_sequence(3);
+	recorder.record("f", sw::manual_clock::now(), 1ms);
+
+	r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 2);
+	REQUIRE(r.events[1].name == "f");
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Flight recorder scopes") {
+	sw::manual_clock::reset();
+
+	{
+		auto recorder = test_flight_recorder(recording_path, 16);
+
+		{
+			auto s = recorder.trace("scope");
+
+			sw::manual_clock::advance(3ms);
+			s.timer().pause();
+			sw::manual_clock::advance(10ms);
+		}
+	}
+
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 1);
+	REQUIRE(r.events[0].name == "scope");
+	REQUIRE(r.events[0].duration_ns == 3'000'000);
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Flight recorder skips torn records") {
+	{
+		auto recorder = sw::flight_recorder(recording_path, 4);
+
+		recorder.record("kept", std::chrono::steady_clock::now(), 1ms);
+		recorder.record("torn", std::chrono::steady_clock::now(), 1ms);
+	}
+
+	// The sequence number of the second record is 0, as if the process died while writing it
+	{
+		auto file = std::fstream(recording_path, std::ios::in | std::ios::out | std::ios::binary);
+		const std::uint64_t zero{};
+
+		file.seekp(64 + 64);
+		file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+	}
+
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 1);
+	REQUIRE(r.events[0].name == "kept");
+
+	std::remove(recording_path.c_str());
+}
+
+TEST_CASE("Reading an invalid flight recorder file") {
+	{
+		auto file = std::ofstream(recording_path, std::ios::binary);
+		file << "not a flight recorder file, but long enough to have a header in it, probably";
+	}
+
+	REQUIRE_THROWS_AS(sw::read_flight_recording(recording_path), std::runtime_error);
+
+	// A capacity whose records would wrap around the size of the file
+	{
+		auto recorder = sw::flight_recorder(recording_path, 4);
+
+		recorder.record("event", std::chrono::steady_clock::now(), 1ms);
+	}
+
+	{
+		auto file = std::fstream(recording_path, std::ios::in | std::ios::out | std::ios::binary);
+		const std::uint64_t capacity{ (std::uint64_t{ 1 } << 58) + 1 };
+
+		file.seekp(offsetof(sw::detail::flight_header, capacity));
+		file.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+	}
+
+	REQUIRE_THROWS_AS(sw::read_flight_recording(recording_path), std::runtime_error);
+
+	std::remove(recording_path.c_str());
+
+	REQUIRE_THROWS_AS(sw::read_flight_recording(recording_path), std::runtime_error);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("Flight recorder events survive the death of the process") {
+	const auto child = fork();
+
+	if (child == 0) {
+		auto recorder = new sw::flight_recorder(recording_path, 16);
+
+		recorder->record("before death", std::chrono::steady_clock::now(), 1ms);
+
+		// Nothing is unmapped or flushed
+		_exit(0);
+	}
+
+	int status{};
+	waitpid(child, &status, 0);
+
+	const auto r = sw::read_flight_recording(recording_path);
+
+	REQUIRE(r.events.size() == 1);
+	REQUIRE(r.events[0].name == "before death");
+
+	std::remove(recording_path.c_str());
+}
+
+#endif
\ No newline at end of file
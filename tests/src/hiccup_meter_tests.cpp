@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include "hiccup_meter.hpp"
+#include "manual_clock.hpp"
+
+#include <atomic>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+// Waits by moving the manual clock to the target, plus an injected stall
+struct stall_wait {
+	std::chrono::nanoseconds* stall;
+
+	void operator()(const sw::manual_clock::time_point& t) const noexcept {
+		sw::manual_clock::set(t);
+		sw::manual_clock::advance(*stall);
+	}
+};
+
+using test_hiccup_meter = sw::basic_hiccup_meter<sw::manual_clock, stall_wait>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Hiccup meter samples") {
+	sw::manual_clock::reset();
+
+	auto stall = std::chrono::nanoseconds(0);
+	auto meter = test_hiccup_meter(1ms, 1s, nullptr, stall_wait{ &stall });
+
+	REQUIRE(meter.sample() == 0ns);
+
+	stall = 300us;
+	REQUIRE(meter.sample() == 300us);
+
+	auto totals = meter.totals();
+
+	REQUIRE(totals.count() == 2);
+	REQUIRE(totals.min() == 0ns);
+	REQUIRE(totals.max() == 300us);
+}
+
+TEST_CASE("Hiccup meter corrects for coordinated omission") {
+	sw::manual_clock::reset();
+
+	auto stall = std::chrono::nanoseconds(3500us);
+	auto meter = test_hiccup_meter(1ms, 1s, nullptr, stall_wait{ &stall });
+
+	REQUIRE(meter.sample() == 3500us);
+
+	// The samples that would have been taken during the stall are recorded too
+	auto totals = meter.totals();
+
+	REQUIRE(totals.count() == 3);
+	REQUIRE(totals.max() == 3500us);
+	REQUIRE(totals.min() == 1500us);
+	REQUIRE(totals.sum() == 7500us);
+}
+
+TEST_CASE("Hiccup meter reports intervals") {
+	sw::manual_clock::reset();
+
+	const auto t0 = sw::manual_clock::now();
+
+	auto reports	= std::vector<test_hiccup_meter::interval_report>();
+	auto stall		= std::chrono::nanoseconds(2ms);
+	auto meter		= test_hiccup_meter(1ms, 1s, [&](const auto& r) { reports.push_back(r); }, stall_wait{ &stall });
+
+	meter.sample();
+
+	auto first = meter.report();
+
+	REQUIRE(reports.size() == 1);
+	REQUIRE(first.begin == t0);
+	REQUIRE(first.end == t0 + 3ms);
+	REQUIRE(first.hiccups.count() == 2);
+
+	stall = 0ns;
+	meter.sample();
+	meter.report();
+
+	REQUIRE(reports.size() == 2);
+	REQUIRE(reports[1].begin == first.end);
+	REQUIRE(reports[1].hiccups.count() == 1);
+	REQUIRE(reports[1].hiccups.max() == 0ns);
+
+	// The totals cover every interval
+	REQUIRE(meter.totals().count() == 3);
+}
+
+TEST_CASE("Hiccup meter background thread") {
+	auto reported	= std::atomic<bool>();
+	auto meter		= sw::hiccup_meter(1ms, 10ms, [&](const auto& r) {
+		if (r.hiccups.count() > 0) reported = true;
+	});
+
+	meter.start();
+
+	auto timer = sw::stopwatch();
+	timer.start();
+
+	while (!reported && timer.get_elapsed() < 10s) std::this_thread::sleep_for(1ms);
+
+	meter.stop();
+
+	REQUIRE(reported);
+	REQUIRE(meter.totals().count() > 0);
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "catch.hpp"
+
+#include "lap_log.hpp"
+#include "manual_clock.hpp"
+#include "stopwatch_policies.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+// A clock that moves forward by a nanosecond every time it's read, so two reads never give the same time.
+struct ticking_clock {
+	using rep			= std::int64_t;
+	using period		= std::nano;
+	using duration		= std::chrono::duration<rep, period>;
+	using time_point	= std::chrono::time_point<ticking_clock>;
+
+	static constexpr bool is_steady = true;
+
+	static time_point now() noexcept {
+		static rep ticks{ 1'000'000 };
+
+		return time_point(duration(++ticks));
+	}
+};
+
+static std::vector<sw::lap_record> read_all(sw::lap_log_reader reader) {
+	auto ret = std::vector<sw::lap_record>();
+	auto lap = sw::lap_record();
+
+	while (reader.next(lap)) ret.push_back(lap);
+
+	return ret;
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Empty lap log") {
+	auto log = sw::lap_log();
+
+	REQUIRE(log.size() == 0);
+	REQUIRE(log.block_count() == 0);
+	REQUIRE(log.used_bytes() == 0);
+	REQUIRE(read_all(sw::lap_log_reader(log)).empty());
+}
+
+TEST_CASE("Lap log round trip") {
+	auto rng	= std::mt19937_64(42);
+	auto jitter	= std::uniform_int_distribution<std::int64_t>(-5'000, 5'000);
+	auto spike	= std::uniform_int_distribution<int>(0, 99);
+	auto laps	= std::vector<sw::lap_record>();
+
+	std::int64_t t = 1'000'000'000'000;
+
+	for (int i{}; i < 10'000; i++) {
+		// Mostly regular laps with some jitter, and the occasional very long one
+		auto d = 1'000'000 + jitter(rng);
+		if (spike(rng) == 0) d *= 1000;
+
+		t += d + (spike(rng) < 10 ? 250 : 0);
+		laps.push_back({ t, d });
+	}
+
+	// Values that need the widest encodings
+	laps.push_back({ std::numeric_limits<std::int64_t>::max() / 4, 0 });
+	laps.push_back({ -1, std::numeric_limits<std::int64_t>::max() / 4 });
+	laps.push_back({ 0, -5 });
+
+	auto log = sw::lap_log(256);
+
+	for (const auto& lap : laps) log.append(lap.timestamp_ns, lap.duration_ns);
+
+	REQUIRE(log.size() == laps.size());
+	REQUIRE(log.block_count() > 1);
+	REQUIRE(log.used_bytes() < laps.size() * 8);
+	REQUIRE(read_all(sw::lap_log_reader(log)) == laps);
+
+	// The same data read back as raw bytes, such as from a file
+	const auto bytes = std::vector<std::uint8_t>(log.data(), log.data() + log.block_count() * log.block_size());
+
+	REQUIRE(read_all(sw::lap_log_reader(bytes.data(), bytes.size(), log.block_size())) == laps);
+}
+
+TEST_CASE("Lap log random access by block") {
+	auto log = sw::lap_log(64);
+
+	for (std::int64_t i{}; i < 1000; i++) log.append(i * 1000 + i * i, i);
+
+	auto reader = sw::lap_log_reader(log);
+	std::size_t first{};
+
+	REQUIRE(reader.block_count() == log.block_count());
+
+	for (std::size_t b{}; b < reader.block_count(); b++) {
+		auto lap = sw::lap_record();
+
+		reader.seek_block(b);
+		REQUIRE(reader.next(lap));
+
+		const auto i = static_cast<std::int64_t>(first);
+
+		REQUIRE(lap.timestamp_ns == i * 1000 + i * i);
+		REQUIRE(lap.duration_ns == i);
+
+		first += reader.block_laps(b);
+	}
+
+	REQUIRE(first == 1000);
+
+	// Reading continues into the following blocks
+	reader.seek_block(reader.block_count() - 2);
+
+	auto tail = read_all(reader);
+
+	REQUIRE(tail.back().duration_ns == 999);
+}
+
+TEST_CASE("Lap log with a stopwatch") {
+	sw::manual_clock::reset();
+
+	auto log	= sw::lap_log();
+	auto timer	= sw::basic_stopwatch<sw::manual_clock>();
+
+	log.lap(timer);
+	sw::manual_clock::advance(3ms);
+	REQUIRE(log.lap(timer) == 3ms);
+	sw::manual_clock::advance(4ms);
+	log.lap(timer);
+
+	const auto laps	= read_all(sw::lap_log_reader(log));
+	const auto t0	= std::chrono::nanoseconds(sw::manual_clock::epoch.time_since_epoch()).count();
+
+	REQUIRE(laps == std::vector<sw::lap_record>{ { t0, 0 }, { t0 + 3'000'000, 3'000'000 }, { t0 + 7'000'000, 4'000'000 } });
+
+	log.clear();
+
+	REQUIRE(log.size() == 0);
+	REQUIRE(read_all(sw::lap_log_reader(log)).empty());
+}
+
+TEST_CASE("Lap log with a stopwatch with policies") {
+	sw::manual_clock::reset();
+
+	auto log	= sw::lap_log();
+	auto timer	= sw::basic_stopwatch<sw::manual_clock, sw::packed_storage, sw::atomic_sync, sw::lap_accumulator>();
+
+	log.lap(timer);
+	sw::manual_clock::advance(3ms);
+	REQUIRE(log.lap(timer) == 3ms);
+
+	const auto t0 = std::chrono::nanoseconds(sw::manual_clock::epoch.time_since_epoch()).count();
+
+	REQUIRE(read_all(sw::lap_log_reader(log)) == std::vector<sw::lap_record>{ { t0, 0 }, { t0 + 3'000'000, 3'000'000 } });
+
+	// The stopwatch recorded the lap too
+	REQUIRE(timer.laps().count() == 1);
+	REQUIRE((timer.laps().max() == 3ms));
+}
+
+TEST_CASE("Lap log timestamps are the ends of the laps") {
+	auto log	= sw::lap_log();
+	auto timer	= sw::basic_stopwatch<ticking_clock>();
+
+	for (int i{}; i < 3; i++) log.lap(timer);
+
+	const auto laps = read_all(sw::lap_log_reader(log));
+
+	REQUIRE(laps.size() == 3);
+
+	// The clock was read once per lap, so each lap ends exactly where the next one starts
+	for (std::size_t i{ 1 }; i < laps.size(); i++) REQUIRE(laps[i].timestamp_ns - laps[i - 1].timestamp_ns == laps[i].duration_ns);
+}
+
+TEST_CASE("Lap log stores the second lap of a block as a delta") {
+	auto log = sw::lap_log(64);
+
+	log.append(1'000'000'000'000, 1000);
+	log.append(1'000'001'000'000, 1000);
+
+	// The header, the first lap in full (69 + 16 bits), and the second one as the change from no delta (37 + 8 bits)
+	REQUIRE(log.used_bytes() == 4 + (69 + 16 + 37 + 8 + 7) / 8);
+
+	// Regular laps after that take a bit and an empty varint
+	log.append(1'000'002'000'000, 1000);
+
+	REQUIRE(log.used_bytes() == 4 + (69 + 16 + 37 + 8 + 1 + 8 + 7) / 8);
+	REQUIRE(read_all(sw::lap_log_reader(log)) == std::vector<sw::lap_record>{ { 1'000'000'000'000, 1000 }, { 1'000'001'000'000, 1000 }, { 1'000'002'000'000, 1000 } });
+}
+
+TEST_CASE("Lap log reader with malformed data") {
+	auto lap = sw::lap_record();
+
+	// Blocks without room for their header
+	auto bytes = std::vector<std::uint8_t>(64, 0xff);
+
+	REQUIRE(sw::lap_log_reader(bytes.data(), bytes.size(), 0).block_count() == 0);
+	REQUIRE(!sw::lap_log_reader(bytes.data(), bytes.size(), 0).next(lap));
+	REQUIRE(!sw::lap_log_reader(bytes.data(), bytes.size(), sw::detail::lap_block_header_size).next(lap));
+
+	// A lap count that runs past the end of the block, whose bits are all ones
+	REQUIRE(read_all(sw::lap_log_reader(bytes.data(), bytes.size(), bytes.size())).empty());
+
+	// A varint longer than 10 groups, after an unchanged delta
+	bytes = std::vector<std::uint8_t>(64, 0xff);
+	sw::detail::write_block_count(bytes.data(), 1);
+	bytes[sw::detail::lap_block_header_size] = 0x7f;
+
+	REQUIRE(read_all(sw::lap_log_reader(bytes.data(), bytes.size(), bytes.size())).empty());
+
+	// Valid laps are read up to a malformed block, and reading stops there
+	auto log = sw::lap_log(64);
+
+	for (int i{}; i < 100; i++) log.append(i * 1000, i);
+
+	bytes.assign(log.data(), log.data() + log.block_count() * log.block_size());
+	std::fill(bytes.begin() + 64 + sw::detail::lap_block_header_size, bytes.begin() + 128, std::uint8_t{ 0xff });
+
+	const auto laps = read_all(sw::lap_log_reader(bytes.data(), bytes.size(), log.block_size()));
+
+	REQUIRE(laps.size() == sw::lap_log_reader(log).block_laps(0));
+	REQUIRE(laps.back() == sw::lap_record{ (static_cast<std::int64_t>(laps.size()) - 1) * 1000, static_cast<std::int64_t>(laps.size()) - 1 });
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "catch.hpp"
+
+#include "lock_profiler.hpp"
+#include "manual_clock.hpp"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace std::literals::chrono_literals;
+
+static sw::lock_contention_stats find_stats(const std::string& name) {
+	for (auto& s : sw::contention_report()) {
+		if (s.name == name) return s;
+	}
+
+	return {};
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("timed_mutex_wrapper with lock_timing::full") {
+	sw::manual_clock::reset();
+
+	auto m = sw::timed_mutex_wrapper<std::mutex, sw::manual_clock>("test full");
+
+	for (int i = 1; i <= 3; i++) {
+		std::lock_guard<decltype(m)> lock(m);
+		sw::manual_clock::advance(i * 1ms);
+	}
+
+	REQUIRE(m.try_lock());
+	m.unlock();
+
+	auto s = find_stats("test full");
+
+	REQUIRE(s.acquisitions == 4);
+	REQUIRE(s.contended == 0);
+	REQUIRE(s.wait.count() == 4);
+	REQUIRE(s.wait.max() == 0ns);
+	REQUIRE(s.hold.count() == 4);
+	REQUIRE(s.hold.max() == 3ms);
+	REQUIRE(s.hold.sum() == 6ms);
+}
+
+TEST_CASE("timed_mutex_wrapper with lock_timing::sampling") {
+	auto m = sw::timed_mutex_wrapper<>("test sampling", sw::lock_timing::sampling);
+
+	// The other thread may only get to lock() after the mutex was released, so the handoff is retried until it was contended
+	int handoffs{};
+
+	for (; handoffs < 100 && find_stats("test sampling").contended == 0; handoffs++) {
+		m.lock();
+
+		auto waiting	= std::atomic<bool>();
+		auto other		= std::thread([&] {
+			waiting = true;
+			m.lock();
+			m.unlock();
+			sw::flush_lock_stats();
+		});
+
+		while (!waiting) std::this_thread::yield();
+		std::this_thread::sleep_for(20ms);
+
+		m.unlock();
+		other.join();
+	}
+
+	REQUIRE(find_stats("test sampling").contended == 1);
+
+	for (int i{}; i < 10; i++) {
+		m.lock();
+		m.unlock();
+	}
+
+	auto s = find_stats("test sampling");
+
+	// Only the contended acquisition is timed
+	REQUIRE(s.acquisitions == static_cast<std::uint64_t>(handoffs) * 2 + 10);
+	REQUIRE(s.contended == 1);
+	REQUIRE(s.wait.count() == 1);
+	REQUIRE(s.wait.max() > 0ns);
+	REQUIRE(s.hold.count() == 1);
+}
+
+TEST_CASE("Locks with the same name share statistics, and reports are ranked") {
+	sw::manual_clock::reset();
+
+	{
+		auto a = sw::timed_mutex_wrapper<std::mutex, sw::manual_clock>("test shared");
+		a.lock();
+		a.unlock();
+	}
+
+	auto b = sw::timed_mutex_wrapper<std::mutex, sw::manual_clock>("test shared");
+	b.lock();
+	b.unlock();
+
+	REQUIRE(find_stats("test shared").acquisitions == 2);
+
+	auto report = sw::contention_report();
+
+	for (std::size_t i = 1; i < report.size(); i++) {
+		REQUIRE(report[i - 1].wait.sum() >= report[i].wait.sum());
+	}
+
+	auto out = std::ostringstream();
+	sw::write_contention_report(out);
+
+	REQUIRE(out.str().find("test shared") != std::string::npos);
+
+	sw::reset_lock_stats();
+
+	REQUIRE(find_stats("test shared").acquisitions == 0);
+	REQUIRE(find_stats("test shared").name == "test shared");
+}
\ No newline at end of file
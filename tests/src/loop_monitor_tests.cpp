@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include "loop_monitor.hpp"
+#include "manual_clock.hpp"
+
+using namespace std::literals::chrono_literals;
+
+using test_loop_monitor = sw::basic_loop_monitor<sw::manual_clock>;
+
+// One loop iteration: busy for `busy`, then idle for `idle`
+static void iterate(test_loop_monitor& monitor, std::chrono::milliseconds busy, std::chrono::milliseconds idle) {
+	sw::manual_clock::advance(busy);
+	monitor.idle([&] { sw::manual_clock::advance(idle); });
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Loop utilization over a single window") {
+	sw::manual_clock::reset();
+
+	auto monitor = test_loop_monitor(100ms);
+
+	REQUIRE(monitor.utilization() == 0.0);
+
+	iterate(monitor, 10ms, 20ms);
+	iterate(monitor, 20ms, 50ms);
+
+	REQUIRE(monitor.utilization() == Approx(0.3));
+
+	iterate(monitor, 90ms, 10ms);
+
+	REQUIRE(monitor.utilization() == Approx(0.9));
+}
+
+TEST_CASE("Loop utilization over rolling windows") {
+	sw::manual_clock::reset();
+
+	auto monitor = test_loop_monitor(100ms, 2);
+
+	iterate(monitor, 20ms, 80ms);
+	REQUIRE(monitor.utilization() == Approx(0.2));
+
+	iterate(monitor, 60ms, 40ms);
+	REQUIRE(monitor.utilization() == Approx(0.4));
+
+	// The first window drops out
+	iterate(monitor, 100ms, 0ms);
+	REQUIRE(monitor.utilization() == Approx(0.8));
+}
+
+TEST_CASE("A window that ends while the loop is idle") {
+	sw::manual_clock::reset();
+
+	auto monitor = test_loop_monitor(100ms);
+
+	iterate(monitor, 50ms, 100ms);
+	REQUIRE(monitor.utilization() == Approx(50.0 / 150.0));
+
+	// The busy time of the next window only starts counting after the idle wait
+	iterate(monitor, 25ms, 75ms);
+	REQUIRE(monitor.utilization() == Approx(0.25));
+}
+
+TEST_CASE("Busy time of the current iteration") {
+	sw::manual_clock::reset();
+
+	auto monitor = test_loop_monitor(1s);
+
+	sw::manual_clock::advance(300ms);
+	REQUIRE(monitor.busy_time() == 300ms);
+
+	monitor.idle_begin();
+	sw::manual_clock::advance(100ms);
+	REQUIRE(monitor.busy_time() == 0ns);
+
+	monitor.idle_end();
+	sw::manual_clock::advance(5ms);
+	REQUIRE(monitor.busy_time() == 5ms);
+}
+
+TEST_CASE("Loop lag") {
+	sw::manual_clock::reset();
+
+	auto monitor = test_loop_monitor(100ms);
+
+	const auto scheduled = sw::manual_clock::now() + 10ms;
+
+	sw::manual_clock::advance(15ms);
+	monitor.record_lag(scheduled);
+
+	REQUIRE(monitor.last_lag() == 5ms);
+	REQUIRE(monitor.max_lag() == 5ms);
+
+	// Callbacks that run early have no lag
+	monitor.record_lag(sw::manual_clock::now() + 1ms);
+
+	REQUIRE(monitor.last_lag() == 0ns);
+	REQUIRE(monitor.max_lag() == 5ms);
+
+	// The maximum covers the last completed window and the current one
+	iterate(monitor, 0ms, 100ms);
+	REQUIRE(monitor.max_lag() == 5ms);
+
+	iterate(monitor, 0ms, 100ms);
+	REQUIRE(monitor.max_lag() == 0ns);
+}
\ No newline at end of file
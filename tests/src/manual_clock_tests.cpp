@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+
+using namespace std::literals::chrono_literals;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("manual_clock advance(), set() and reset()") {
+	sw::manual_clock::reset();
+
+	auto t0 = sw::manual_clock::now();
+
+	REQUIRE((t0 == sw::manual_clock::epoch));
+	REQUIRE((sw::manual_clock::now() == t0));
+
+	sw::manual_clock::advance(5ms);
+
+	REQUIRE((sw::manual_clock::now() - t0 == 5ms));
+
+	sw::manual_clock::advance(-5ms);
+	sw::manual_clock::advance(sw::d_nanoseconds(0.5));
+
+	REQUIRE((sw::manual_clock::now() - t0 == 5ms + 1ns));
+
+	sw::manual_clock::set(t0 + 1s);
+
+	REQUIRE((sw::manual_clock::now() - t0 == 1s));
+
+	sw::manual_clock::set(t0);
+
+	REQUIRE((sw::manual_clock::now() - t0 == 1s));
+
+	sw::manual_clock::reset();
+
+	REQUIRE((sw::manual_clock::now() == t0));
+}
+
+TEST_CASE("basic_manual_clock instances with different tags are independent") {
+	struct tag_a {};
+	struct tag_b {};
+
+	using clock_a = sw::basic_manual_clock<tag_a>;
+	using clock_b = sw::basic_manual_clock<tag_b>;
+
+	clock_a::advance(1s);
+
+	REQUIRE((clock_a::now() - clock_a::epoch == 1s));
+	REQUIRE((clock_b::now() == clock_b::epoch));
+
+	auto timer = sw::basic_stopwatch<clock_b>();
+
+	timer.start();
+	clock_a::advance(1s);
+	clock_b::advance(3ms);
+
+	REQUIRE((timer.get_elapsed() == 3ms));
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "open_metrics.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals::chrono_literals;
+
+#ifndef _WIN32
+
+// Sends a request to a server on localhost, and returns the whole response.
+static std::string http_get(std::uint16_t port, const std::string& path) {
+	const int s = socket(AF_INET, SOCK_STREAM, 0);
+	REQUIRE(s >= 0);
+
+	sockaddr_in addr{};
+	addr.sin_family	= AF_INET;
+	addr.sin_port	= htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+	REQUIRE(connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+	const auto request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	REQUIRE(send(s, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+
+	auto response = std::string();
+	char buffer[1024];
+
+	for (ssize_t n; (n = recv(s, buffer, sizeof(buffer), 0)) > 0;) response.append(buffer, static_cast<std::size_t>(n));
+
+	close(s);
+
+	return response;
+}
+
+#endif
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("OpenMetrics counter") {
+	sw::manual_clock::reset();
+
+	auto registry	= sw::open_metrics_registry();
+	auto& counter	= registry.counter("gc_pause_seconds", "Time spent in \"GC\" pauses");
+
+	counter.record(1500ms);
+
+	auto timer = sw::basic_stopwatch<sw::manual_clock>();
+	timer.start();
+	sw::manual_clock::advance(5ms);
+	counter.record(timer);
+
+	REQUIRE(counter.count() == 2);
+	REQUIRE(counter.sum() == 1505ms);
+
+	REQUIRE(registry.render() ==
+		"# TYPE gc_pause_seconds counter\n"
+		"# UNIT gc_pause_seconds seconds\n"
+		"# HELP gc_pause_seconds Time spent in \\\"GC\\\" pauses\n"
+		"gc_pause_seconds_total 1.505\n"
+		"# EOF\n");
+}
+
+TEST_CASE("OpenMetrics histogram") {
+	auto registry	= sw::open_metrics_registry();
+	auto& h			= registry.histogram("request_seconds", "", { 1ms, 10ms, 1s });
+
+	h.record(500us);
+	h.record(1ms);		// Bounds are inclusive
+	h.record(2ms);
+	h.record(5s);
+
+	REQUIRE(h.count() == 4);
+	REQUIRE(h.bounds().size() == 3);
+
+	REQUIRE(registry.render() ==
+		"# TYPE request_seconds histogram\n"
+		"# UNIT request_seconds seconds\n"
+		"request_seconds_bucket{le=\"0.001\"} 2\n"
+		"request_seconds_bucket{le=\"0.01\"} 3\n"
+		"request_seconds_bucket{le=\"1\"} 3\n"
+		"request_seconds_bucket{le=\"+Inf\"} 4\n"
+		"request_seconds_count 4\n"
+		"request_seconds_sum 5.0035\n"
+		"# EOF\n");
+
+	REQUIRE(registry.histogram("default_seconds").bounds() == sw::open_metrics_registry::default_bounds);
+	REQUIRE_THROWS_AS(registry.histogram("unsorted", "", { 10ms, 1ms }), std::invalid_argument);
+}
+
+TEST_CASE("OpenMetrics summary") {
+	auto registry	= sw::open_metrics_registry();
+	auto& s			= registry.summary("latency", "", { 0, 0.5, 1 });
+
+	for (int i = 1; i <= 100; i++) s.record(std::chrono::milliseconds(i));
+
+	REQUIRE(s.count() == 100);
+	REQUIRE(s.quantile(0.0) == 1ms);
+	REQUIRE(s.quantile(1.0) == 100ms);
+
+	// Within the 1/16 error of the buckets
+	REQUIRE(s.quantile(0.5) > 47ms);
+	REQUIRE(s.quantile(0.5) < 53ms);
+
+	const auto text = registry.render();
+
+	// No unit, since the name doesn't end with one
+	REQUIRE(text.rfind("# TYPE latency summary\nlatency{quantile=\"0\"} 0.001\nlatency{quantile=\"0.5\"} 0.0", 0) == 0);
+	REQUIRE(text.find("latency{quantile=\"1\"} 0.1\n") != std::string::npos);
+	REQUIRE(text.find("latency_count 100\nlatency_sum 5.05\n# EOF\n") != std::string::npos);
+
+	REQUIRE_THROWS_AS(registry.summary("bad_quantile", "", { 1.5 }), std::invalid_argument);
+}
+
+TEST_CASE("OpenMetrics registry") {
+	auto registry = sw::open_metrics_registry();
+
+	auto& a = registry.counter("a");
+	auto& b = registry.histogram("b");
+
+	// The same name returns the same metric
+	REQUIRE(&registry.counter("a") == &a);
+	REQUIRE(&registry.histogram("b") == &b);
+
+	REQUIRE_THROWS_AS(registry.summary("a"), std::invalid_argument);
+	REQUIRE_THROWS_AS(registry.counter("1abc"), std::invalid_argument);
+	REQUIRE_THROWS_AS(registry.counter("a-b"), std::invalid_argument);
+	REQUIRE_THROWS_AS(registry.counter(""), std::invalid_argument);
+
+	REQUIRE(sw::open_metrics_registry().render() == "# EOF\n");
+}
+
+TEST_CASE("OpenMetrics rendering while recording") {
+	auto registry	= sw::open_metrics_registry();
+	auto& h			= registry.histogram("busy_seconds", "", { 1us, 1ms });
+	auto stop		= std::atomic<bool>();
+
+	auto writer = std::thread([&] {
+		for (int i{}; !stop.load(std::memory_order_relaxed); i++) h.record(std::chrono::microseconds(i % 2000));
+	});
+
+	// The +Inf bucket always matches the count
+	for (int i{}; i < 200; i++) {
+		const auto text		= registry.render();
+		const auto inf		= text.find("le=\"+Inf\"} ");
+		const auto count	= text.find("busy_seconds_count ");
+
+		const auto inf_value	= text.substr(inf + 11, text.find('\n', inf) - inf - 11);
+		const auto count_value	= text.substr(count + 19, text.find('\n', count) - count - 19);
+
+		REQUIRE(inf_value == count_value);
+	}
+
+	stop = true;
+	writer.join();
+}
+
+#ifndef _WIN32
+
+TEST_CASE("OpenMetrics server") {
+	auto registry = sw::open_metrics_registry();
+	registry.counter("served_seconds").record(2s);
+
+	auto server = sw::open_metrics_server(registry, 0);
+
+	REQUIRE(server.port() != 0);
+
+	const auto ok = http_get(server.port(), "/metrics");
+
+	REQUIRE(ok.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+	REQUIRE(ok.find("Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n") != std::string::npos);
+	REQUIRE(ok.find("\r\n\r\n" + registry.render()) != std::string::npos);
+
+	// Metrics added later are served too
+	registry.counter("later_seconds").record(1s);
+	REQUIRE(http_get(server.port(), "/metrics").find("later_seconds_total 1\n") != std::string::npos);
+
+	REQUIRE(http_get(server.port(), "/").rfind("HTTP/1.1 404 Not Found\r\n", 0) == 0);
+
+	REQUIRE_THROWS_AS(sw::open_metrics_server(registry, 0, "not an address"), std::invalid_argument);
+}
+
+#endif
\ No newline at end of file
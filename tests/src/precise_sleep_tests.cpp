@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "precise_sleep.hpp"
+
+using namespace std::literals::chrono_literals;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("precise_sleep_for() never wakes up early") {
+	auto timer = sw::stopwatch();
+
+	for (auto d : { 0ms, 1ms, 3ms, 10ms }) {
+		timer.start();
+		sw::precise_sleep_for(d);
+		auto t = timer.get_elapsed();
+
+		REQUIRE((t >= d));
+		REQUIRE((t < d + 50ms));
+	}
+}
+
+TEST_CASE("precise_sleep_until() with a spin budget of 0") {
+	auto timer		= sw::stopwatch();
+	auto deadline	= sw::stopwatch::clock::now() + 5ms;
+
+	timer.start();
+	sw::precise_sleep_until(deadline, 0ns);
+	auto t = timer.get_elapsed();
+
+	REQUIRE((sw::stopwatch::clock::now() >= deadline));
+	REQUIRE((t < 55ms));
+}
+
+TEST_CASE("precise_sleep_until() with a deadline in the past") {
+	auto timer = sw::stopwatch();
+
+	timer.start();
+	sw::precise_sleep_until(sw::stopwatch::clock::now() - 1s);
+
+	REQUIRE((timer.get_elapsed() < 50ms));
+}
+
+TEST_CASE("sleep_calibration") {
+	auto calibration = sw::sleep_calibration();
+
+	REQUIRE(calibration.samples() == 0);
+
+	calibration.record(2ms);
+	calibration.record(2ms);
+
+	REQUIRE(calibration.samples() == 2);
+	REQUIRE(calibration.estimate() == 2ms);
+
+	calibration.record(5ms);
+
+	REQUIRE(calibration.estimate() > 3ms);
+
+	sw::precise_sleep_for(10ms);
+
+	REQUIRE(sw::sleep_calibration::this_thread().samples() > 0);
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "catch.hpp"
+
+#include "rate_limiter.hpp"
+#include "manual_clock.hpp"
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("token_bucket") {
+	sw::manual_clock::reset();
+
+	auto bucket = sw::basic_token_bucket<sw::manual_clock>(10.0, 5);
+
+	REQUIRE(bucket.capacity() == 5);
+	REQUIRE(bucket.available() == 5);
+	REQUIRE(bucket.try_acquire(3));
+	REQUIRE(bucket.available() == 2);
+	REQUIRE(!bucket.try_acquire(3));
+	REQUIRE(bucket.available() == 2);
+	REQUIRE(bucket.try_acquire(2));
+	REQUIRE(!bucket.try_acquire());
+	REQUIRE(bucket.time_until_available(2) == 200ms);
+
+	sw::manual_clock::advance(150ms);
+
+	REQUIRE(bucket.available() == 1);
+	REQUIRE(bucket.time_until_available() == 0ms);
+	REQUIRE(bucket.time_until_available(2) == 50ms);
+	REQUIRE(bucket.try_acquire());
+	REQUIRE(!bucket.try_acquire());
+
+	// Never holds more than the capacity
+	sw::manual_clock::advance(1h);
+
+	REQUIRE(bucket.available() == 5);
+	REQUIRE(!bucket.try_acquire(6));
+	REQUIRE(bucket.try_acquire(5));
+}
+
+TEST_CASE("token_bucket with a rate that isn't positive") {
+	sw::manual_clock::reset();
+
+	for (const auto rate : { 0.0, -1.0, std::numeric_limits<double>::quiet_NaN() }) {
+		auto bucket = sw::basic_token_bucket<sw::manual_clock>(rate, 2);
+
+		REQUIRE(bucket.try_acquire(2));
+		REQUIRE(!bucket.try_acquire());
+
+		// Years later, the bucket still hasn't refilled
+		sw::manual_clock::advance(24h * 365 * 10);
+
+		REQUIRE(!bucket.try_acquire());
+		REQUIRE(bucket.time_until_available() > 24h * 365 * 10);
+		REQUIRE(!bucket.try_acquire(3));
+	}
+}
+
+TEST_CASE("gcra") {
+	sw::manual_clock::reset();
+
+	auto limiter = sw::basic_gcra<sw::manual_clock>(100ms, 2);
+
+	REQUIRE(limiter.emission_interval() == 100ms);
+	REQUIRE(limiter.burst() == 2);
+	REQUIRE(limiter.try_acquire());
+	REQUIRE(limiter.try_acquire());
+	REQUIRE(!limiter.try_acquire());
+	REQUIRE(limiter.retry_after() == 100ms);
+
+	sw::manual_clock::advance(40ms);
+
+	REQUIRE(limiter.retry_after() == 60ms);
+	REQUIRE(!limiter.try_acquire());
+
+	sw::manual_clock::advance(60ms);
+
+	REQUIRE(limiter.retry_after() == 0ms);
+	REQUIRE(limiter.try_acquire());
+	REQUIRE(!limiter.try_acquire());
+
+	// Infinite and NaN intervals are capped, and never let more than a burst through
+	for (const auto interval : { std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN() }) {
+		auto slow = sw::basic_gcra<sw::manual_clock>(std::chrono::duration<double>(interval), 1);
+
+		REQUIRE(slow.try_acquire());
+		REQUIRE(!slow.try_acquire());
+		REQUIRE(slow.emission_interval() > 24h);
+	}
+}
+
+TEST_CASE("Rate limiters are exact under contention") {
+	sw::manual_clock::reset();
+
+	auto bucket		= sw::basic_token_bucket<sw::manual_clock>(1.0, 1000);
+	auto allowed	= std::atomic<int>();
+	auto threads	= std::vector<std::thread>();
+
+	for (int t{}; t < 4; t++) {
+		threads.emplace_back([&] {
+			for (int i{}; i < 10000; i++) {
+				if (bucket.try_acquire()) allowed++;
+			}
+		});
+	}
+
+	for (auto& t : threads) t.join();
+
+	REQUIRE(allowed == 1000);
+}
\ No newline at end of file
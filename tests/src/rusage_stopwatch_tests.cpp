@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "rusage_stopwatch.hpp"
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+using test_rusage_stopwatch = sw::basic_rusage_stopwatch<sw::manual_clock>;
+
+// Touches fresh memory, which causes minor page faults. The blocks are kept, so that freed memory isn't reused.
+static void touch_memory() {
+	constexpr std::size_t size = 4 << 20;
+
+	static auto blocks = std::vector<std::unique_ptr<char[]>>();
+
+	auto& block = blocks.emplace_back(std::make_unique<char[]>(size));
+	std::memset(block.get(), 1, size);
+
+	REQUIRE(block[size / 2] == 1);
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("rusage_stopwatch elapsed time works like basic_stopwatch") {
+	sw::manual_clock::reset();
+
+	auto timer = test_rusage_stopwatch();
+
+	REQUIRE(timer.is_paused());
+	REQUIRE(timer.start() == 0ns);
+
+	sw::manual_clock::advance(10ms);
+	timer.pause();
+	sw::manual_clock::advance(10ms);
+
+	REQUIRE(timer.get_elapsed() == 10ms);
+
+	timer.start();
+	sw::manual_clock::advance(5ms);
+
+	REQUIRE(timer.get_elapsed<std::chrono::milliseconds>() == 15ms);
+
+	// Restarting works as a lap
+	REQUIRE(timer.start() == 15ms);
+	REQUIRE(timer.get_elapsed() == 0ns);
+
+	timer.reset();
+
+	REQUIRE(timer.is_paused());
+	REQUIRE(timer.get_elapsed() == 0ns);
+}
+
+TEST_CASE("resource_usage arithmetic") {
+	const auto a = sw::resource_usage{ 10, 1, 5, 2 };
+	const auto b = sw::resource_usage{ 3, 1, 2, 1 };
+	const auto d = a - b;
+
+	REQUIRE(d.minor_faults == 7);
+	REQUIRE(d.major_faults == 0);
+	REQUIRE(d.voluntary_switches == 3);
+	REQUIRE(d.involuntary_switches == 1);
+
+	const auto s = d + b;
+
+	REQUIRE(s.minor_faults == a.minor_faults);
+	REQUIRE(s.involuntary_switches == a.involuntary_switches);
+}
+
+#ifdef __linux__
+
+TEST_CASE("rusage_stopwatch counts page faults and context switches") {
+	auto timer = sw::rusage_stopwatch();
+
+	REQUIRE(timer.get_usage().minor_faults == 0);
+
+	timer.start();
+	touch_memory();
+	std::this_thread::sleep_for(1ms);
+
+	const auto usage = timer.get_usage();
+
+	REQUIRE(usage.minor_faults > 0);
+	REQUIRE(usage.voluntary_switches > 0);
+
+	// Nothing is counted while paused
+	timer.pause();
+
+	const auto paused = timer.get_usage();
+
+	touch_memory();
+
+	REQUIRE(timer.get_usage().minor_faults == paused.minor_faults);
+
+	// Resuming adds to the previous usage
+	timer.start();
+	touch_memory();
+	timer.pause();
+
+	REQUIRE(timer.get_usage().minor_faults > paused.minor_faults);
+
+	// Restarting a running stopwatch clears it
+	timer.start();
+	timer.start();
+
+	REQUIRE(timer.get_usage().minor_faults < paused.minor_faults);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "sampled_scope.hpp"
+
+#include <cstdint>
+
+using namespace std::literals::chrono_literals;
+
+using test_timer = sw::basic_sampled_timer<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Sampled timer with a period of 1 times every call") {
+	sw::manual_clock::reset();
+
+	auto timer = test_timer(1);
+
+	for (int i{}; i < 10; i++) {
+		auto scope = timer.measure();
+
+		REQUIRE(scope.is_sampled());
+
+		sw::manual_clock::advance(std::chrono::milliseconds(i + 1));
+	}
+
+	REQUIRE(timer.calls() == 10);
+	REQUIRE(timer.samples() == 10);
+	REQUIRE(timer.stats().count() == 10);
+	REQUIRE(timer.stats().min() == 1ms);
+	REQUIRE(timer.stats().max() == 10ms);
+	REQUIRE(timer.stats().sum() == 55ms);
+}
+
+TEST_CASE("Sampled timer scales its statistics to every call") {
+	sw::manual_clock::reset();
+
+	constexpr int calls = 100'000;
+
+	auto timer = test_timer(16);
+
+	REQUIRE(timer.period() == 16);
+
+	std::uint64_t sampled{};
+
+	for (int i{}; i < calls; i++) {
+		auto scope = timer.measure();
+
+		if (scope.is_sampled()) sampled++;
+
+		sw::manual_clock::advance(1us);
+	}
+
+	REQUIRE(timer.calls() == calls);
+	REQUIRE(timer.samples() == sampled);
+
+	// About 1 in 16 calls is timed
+	REQUIRE(sampled > calls / 16 * 9 / 10);
+	REQUIRE(sampled < calls / 16 * 11 / 10);
+
+	// Each sample stands for the calls since the previous one, so only the calls after the last sample are missing
+	REQUIRE(timer.stats().count() <= calls);
+	REQUIRE(timer.stats().count() > calls - 2 * 16);
+	REQUIRE(timer.stats().mean() == 1us);
+	REQUIRE(timer.stats().sum().count() == Approx(std::chrono::nanoseconds(1us).count() * calls).epsilon(0.001));
+
+	timer.reset();
+
+	REQUIRE(timer.calls() == 0);
+	REQUIRE(timer.samples() == 0);
+	REQUIRE(timer.stats().count() == 0);
+	REQUIRE(timer.period() == 16);
+}
+
+TEST_CASE("Sampled timers don't sample the same calls") {
+	auto a = test_timer(8);
+	auto b = test_timer(8);
+
+	int different{};
+
+	for (int i{}; i < 1000; i++) {
+		const auto sa = a.measure();
+		const auto sb = b.measure();
+
+		if (sa.is_sampled() != sb.is_sampled()) different++;
+	}
+
+	REQUIRE(different > 0);
+}
+
+TEST_CASE("Adaptive sampled timer targets its overhead") {
+	sw::manual_clock::reset();
+
+	// Timing a call costs 100 ns, and the calls take 10 us, so timing every call costs 1%
+	auto settings			= sw::adaptive_sampling();
+	settings.clock_cost		= 100ns;
+
+	SECTION("Target of 0.1%") {
+		settings.target_overhead = 0.001;
+
+		auto timer = test_timer(settings);
+
+		// Every call is timed until something is known about them
+		REQUIRE(timer.period() == 1);
+
+		for (int i{}; i < 1000; i++) {
+			auto scope = timer.measure();
+			sw::manual_clock::advance(10us);
+		}
+
+		REQUIRE(timer.period() == 10);
+		REQUIRE(timer.samples() < 200);
+		REQUIRE(timer.stats().mean() == 10us);
+	}
+
+	SECTION("The period is limited") {
+		settings.target_overhead	= 0.000'001;
+		settings.max_period			= 50;
+
+		auto timer = test_timer(settings);
+
+		for (int i{}; i < 1000; i++) {
+			auto scope = timer.measure();
+			sw::manual_clock::advance(10us);
+		}
+
+		REQUIRE(timer.period() == 50);
+	}
+
+	SECTION("Slow calls are timed every time") {
+		settings.target_overhead = 0.01;
+
+		auto timer = test_timer(settings);
+
+		for (int i{}; i < 100; i++) {
+			auto scope = timer.measure();
+			sw::manual_clock::advance(1ms);
+		}
+
+		REQUIRE(timer.period() == 1);
+		REQUIRE(timer.samples() == 100);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "catch.hpp"
+
+#include "shm_metrics.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals::chrono_literals;
+
+// Segment names are unique per process, so parallel test runs don't collide.
+static std::string segment_name(const char* test) {
+	return "sw_tests_" + std::string(test) + "_" + std::to_string(sw::detail::current_pid());
+}
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Shared memory metrics are read back") {
+	const auto name = segment_name("read_back");
+
+	auto registry	= sw::shm_metrics_registry(name, 4);
+	auto requests	= registry.histogram("requests");
+	auto queries	= registry.accumulator("queries");
+
+	requests.record(10ms);
+	requests.record(30ms);
+	queries.record(5us);
+
+	// The same name returns the same metric
+	registry.histogram("requests").record(20ms);
+
+	REQUIRE(registry.size() == 2);
+	REQUIRE(registry.capacity() == 4);
+	REQUIRE(std::string(requests.name()) == "requests");
+
+	const auto reader	= sw::shm_metrics_reader(name);
+	const auto metrics	= reader.read();
+
+	REQUIRE(reader.pid() == sw::detail::current_pid());
+	REQUIRE(reader.capacity() == 4);
+	REQUIRE(metrics.size() == 2);
+
+	REQUIRE(metrics[0].name == "requests");
+	REQUIRE(metrics[0].kind == sw::shm_metric_kind::histogram);
+	REQUIRE(metrics[0].histogram.count() == 3);
+	REQUIRE(metrics[0].histogram.min() == 10ms);
+	REQUIRE(metrics[0].histogram.max() == 30ms);
+
+	REQUIRE(metrics[1].name == "queries");
+	REQUIRE(metrics[1].kind == sw::shm_metric_kind::accumulator);
+	REQUIRE(metrics[1].accumulator.count() == 1);
+	REQUIRE(metrics[1].accumulator.mean() == 5us);
+
+	// Metrics registered after the reader was created are seen too
+	registry.accumulator("late").record(1ms);
+
+	REQUIRE(reader.read().size() == 3);
+}
+
+TEST_CASE("Shared memory metric registration errors") {
+	auto registry = sw::shm_metrics_registry(segment_name("errors"), 1);
+
+	(void)registry.accumulator("only");
+
+	REQUIRE_THROWS_AS(registry.histogram("only"), std::invalid_argument);
+	REQUIRE_THROWS_AS(registry.accumulator("another"), std::length_error);
+
+	// Long names are cut off
+	auto long_registry	= sw::shm_metrics_registry(segment_name("long"), 1);
+	auto metric			= long_registry.accumulator(std::string(100, 'x'));
+
+	REQUIRE(std::string(metric.name()) == std::string(47, 'x'));
+}
+
+TEST_CASE("Shared memory metrics reader errors") {
+	REQUIRE_THROWS_AS(sw::shm_metrics_reader(segment_name("missing")), std::system_error);
+
+	// The segment is removed with the registry
+	const auto name = segment_name("removed");
+
+	{
+		auto registry = sw::shm_metrics_registry(name);
+	}
+
+	REQUIRE_THROWS_AS(sw::shm_metrics_reader(name), std::system_error);
+
+	// A count past the capacity, as a broken writer could leave it, reads only the metrics there's room for
+	const auto broken_name = segment_name("broken");
+
+	auto mapping	= sw::detail::shm_mapping(broken_name, sizeof(sw::detail::shm_header) + 2 * sw::detail::shm_slot_size);
+	auto header		= new (mapping.data()) sw::detail::shm_header{};
+
+	header->version				= sw::detail::shm_version;
+	header->slot_size			= static_cast<std::uint32_t>(sw::detail::shm_slot_size);
+	header->capacity			= 2;
+	header->accumulator_size	= static_cast<std::uint32_t>(sizeof(sw::duration_accumulator));
+	header->histogram_size		= static_cast<std::uint32_t>(sizeof(sw::duration_histogram));
+	header->count				= 1000;
+	std::memcpy(header->magic, sw::detail::shm_magic, sizeof(header->magic));
+
+	for (std::size_t i{}; i < 2; i++) {
+		auto slot = new (static_cast<char*>(mapping.data()) + sizeof(sw::detail::shm_header) + i * sw::detail::shm_slot_size) sw::detail::shm_slot{};
+
+		slot->kind = sw::shm_metric_kind::accumulator;
+	}
+
+	REQUIRE(sw::shm_metrics_reader(broken_name).read().size() == 2);
+}
+
+TEST_CASE("Shared memory metric snapshots are consistent while being written") {
+	const auto name = segment_name("consistent");
+
+	auto registry	= sw::shm_metrics_registry(name);
+	auto metric		= registry.histogram("busy");
+	auto stop		= std::atomic<bool>();
+
+	// Two writers on the same metric take turns. They record a minimum amount, in case they only get to run after the reads
+	auto writer = [&] {
+		for (int i{}; i < 10'000 || !stop.load(std::memory_order_relaxed); i++) metric.record(std::chrono::nanoseconds(i % 100'000));
+	};
+
+	auto a = std::thread(writer);
+	auto b = std::thread(writer);
+
+	const auto reader = sw::shm_metrics_reader(name);
+
+	for (int i{}; i < 200; i++) {
+		for (const auto& m : reader.read()) {
+			std::uint64_t total{};
+
+			for (std::size_t j{}; j < sw::duration_histogram::bucket_count; j++) total += m.histogram.bucket(j);
+
+			REQUIRE(total == m.histogram.count());
+		}
+	}
+
+	stop = true;
+	a.join();
+	b.join();
+
+	const auto metrics = reader.read();
+
+	REQUIRE(metrics.size() == 1);
+	REQUIRE(metrics[0].histogram.count() >= 20'000);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("Shared memory metrics are readable from another process") {
+	const auto name = segment_name("process");
+
+	auto registry = sw::shm_metrics_registry(name);
+
+	registry.accumulator("parent").record(42ms);
+
+	const auto pid = fork();
+	REQUIRE(pid >= 0);
+
+	if (pid == 0) {
+		try {
+			const auto metrics = sw::shm_metrics_reader(name).read();
+			const auto ok = metrics.size() == 1 && metrics[0].name == "parent" && metrics[0].accumulator.max() == 42ms;
+
+			_exit(ok ? 0 : 1);
+		} catch (...) {
+			_exit(2);
+		}
+	}
+
+	int status{};
+	waitpid(pid, &status, 0);
+
+	REQUIRE(WIFEXITED(status));
+	REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+#endif
\ No newline at end of file
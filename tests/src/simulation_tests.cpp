@@ -0,0 +1,88 @@
+#include "catch.hpp"
+
+#include "simulation.hpp"
+
+#include <string>
+
+using namespace std::literals::chrono_literals;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("simulation runs events in time order") {
+	auto sim	= sw::simulation();
+	auto t0		= sw::sim_clock::now();
+	auto log	= std::string();
+
+	sim.schedule_after(30ms, [&] { log += 'c'; });
+	sim.schedule_after(10ms, [&] { log += 'a'; });
+	sim.schedule_after(20ms, [&] { log += 'b'; });
+	sim.schedule_after(20ms, [&] { log += 'B'; });
+
+	REQUIRE(sim.pending() == 4);
+	REQUIRE((sim.next_event_time() == t0 + 10ms));
+	REQUIRE(sim.run() == 4);
+	REQUIRE(log == "abBc");
+	REQUIRE((sw::sim_clock::now() - t0 == 30ms));
+	REQUIRE(!sim.has_pending());
+}
+
+TEST_CASE("simulation cancel() and run_until()") {
+	auto sim	= sw::simulation();
+	auto t0		= sw::sim_clock::now();
+	int count{};
+
+	auto id = sim.schedule_after(5ms, [&] { count += 100; });
+	sim.schedule_after(10ms, [&] { count++; });
+	sim.schedule_after(1s, [&] { count++; });
+
+	REQUIRE(sim.cancel(id));
+	REQUIRE(!sim.cancel(id));
+	REQUIRE((sim.next_event_time() == t0 + 10ms));
+	REQUIRE(sim.run_for(500ms) == 1);
+	REQUIRE(count == 1);
+	REQUIRE((sw::sim_clock::now() - t0 == 500ms));
+	REQUIRE(sim.run_until(t0 + 2s) == 1);
+	REQUIRE(count == 2);
+	REQUIRE((sw::sim_clock::now() - t0 == 2s));
+}
+
+TEST_CASE("simulation with stopwatches and self-rescheduling actors") {
+	auto sim		= sw::simulation();
+	auto t0			= sw::sim_clock::now();
+	auto latency	= sw::sim_clock::duration::zero();
+	int requests{};
+
+	// A client sending a request every 100 ms for 10 hours, each of which takes 3 ms to serve
+	std::function<void()> client = [&] {
+		auto timer = sw::basic_stopwatch<sw::sim_clock>();
+		timer.start();
+
+		sim.schedule_after(3ms, [&, timer] {
+			latency += timer.get_elapsed();
+			requests++;
+		});
+
+		if (sw::sim_clock::now() - t0 < 10h) sim.schedule_after(100ms, client);
+	};
+
+	sim.schedule_after(0ms, client);
+	sim.run();
+
+	REQUIRE(requests == 360001);
+	REQUIRE((latency == requests * 3ms));
+
+	auto deadline	= sw::basic_stopwatch<sw::sim_clock>();
+	bool expired	= false;
+
+	deadline.start();
+	sim.schedule_after(2ms, [] {});
+	sim.step();
+	sim.schedule_on_elapsed(deadline, 5ms, [&] { expired = deadline.get_elapsed() == 5ms; });
+	sim.run();
+
+	REQUIRE(expired);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "stopwatch_array.hpp"
+#include "stopwatch_policies.hpp"
+
+#include <cstdint>
+#include <utility>
+
+using namespace std::literals::chrono_literals;
+
+using test_array = sw::basic_stopwatch_array<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Stopwatch array puts every stopwatch on its own cache line") {
+	auto array = sw::stopwatch_array(5);
+
+	REQUIRE(array.size() == 5);
+
+	for (std::size_t i{}; i < array.size(); i++) {
+		REQUIRE(reinterpret_cast<std::uintptr_t>(&array[i]) % sw::detail::cache_line_size == 0);
+		REQUIRE(array[i].is_paused());
+	}
+
+	REQUIRE(reinterpret_cast<std::uintptr_t>(&array[1]) - reinterpret_cast<std::uintptr_t>(&array[0]) == sw::detail::cache_line_size);
+
+	// Stopwatches bigger than a cache line are padded to a multiple of it
+	auto big = sw::basic_stopwatch_array<std::chrono::steady_clock, sw::lap_histogram>(2);
+
+	REQUIRE((reinterpret_cast<std::uintptr_t>(&big[1]) - reinterpret_cast<std::uintptr_t>(&big[0])) % sw::detail::cache_line_size == 0);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(&big[1]) - reinterpret_cast<std::uintptr_t>(&big[0]) >= sizeof(big[0]));
+}
+
+TEST_CASE("Stopwatch array stopwatches are independent") {
+	sw::manual_clock::reset();
+
+	auto array = test_array(3);
+
+	array[0].start();
+	sw::manual_clock::advance(10ms);
+	array[1].start();
+	sw::manual_clock::advance(5ms);
+
+	const auto& view = array;
+
+	REQUIRE((view[0].get_elapsed() == 15ms));
+	REQUIRE((view[1].get_elapsed() == 5ms));
+	REQUIRE(view[2].is_paused());
+
+	// Moving keeps the stopwatches
+	auto moved = std::move(array);
+
+	REQUIRE(moved.size() == 3);
+	REQUIRE((moved[0].get_elapsed() == 15ms));
+
+	moved.reset();
+
+	for (std::size_t i{}; i < moved.size(); i++) REQUIRE(moved[i].is_paused());
+}
\ No newline at end of file
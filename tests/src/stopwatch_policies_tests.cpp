@@ -0,0 +1,192 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "stopwatch_policies.hpp"
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+// The default policies leave sw::stopwatch as it was: two time points, trivially copyable.
+static_assert(sizeof(sw::stopwatch) == 2 * sizeof(std::chrono::steady_clock::time_point));
+static_assert(std::is_trivially_copyable_v<sw::stopwatch>);
+static_assert(std::is_same_v<sw::stopwatch::storage_policy, sw::split_storage>);
+static_assert(std::is_same_v<sw::stopwatch::sync_policy, sw::no_sync>);
+static_assert(std::is_same_v<sw::stopwatch::laps_policy, sw::no_laps>);
+
+// Policies can be given in any order.
+static_assert(std::is_same_v<sw::basic_stopwatch<sw::manual_clock, sw::lap_histogram, sw::packed_storage>::storage_policy, sw::packed_storage>);
+static_assert(std::is_same_v<sw::basic_stopwatch<sw::manual_clock, sw::lap_histogram, sw::packed_storage>::laps_policy, sw::lap_histogram>);
+
+// Packed storage halves the size, and fits in a lock-free atomic.
+static_assert(sizeof(sw::basic_stopwatch<std::chrono::steady_clock, sw::packed_storage>) == 8);
+static_assert(sizeof(sw::basic_stopwatch<std::chrono::steady_clock, sw::packed_storage, sw::atomic_sync>) == 8);
+
+// A clock whose times are before its epoch, which packed storage keeps with their sign.
+struct negative_clock {
+	using rep			= std::int64_t;
+	using period		= std::nano;
+	using duration		= std::chrono::duration<rep, period>;
+	using time_point	= std::chrono::time_point<negative_clock>;
+
+	static constexpr bool is_steady = true;
+
+	static time_point now() noexcept {
+		return time_point(sw::manual_clock::now().time_since_epoch() - 1000h);
+	}
+};
+
+
+
+// ========================= Test cases
+
+
+
+TEMPLATE_TEST_CASE("Stopwatch policies behave like the default stopwatch", "",
+	(sw::basic_stopwatch<sw::manual_clock>),
+	(sw::basic_stopwatch<sw::manual_clock, sw::packed_storage>),
+	(sw::basic_stopwatch<sw::manual_clock, sw::seqlock_sync>),
+	(sw::basic_stopwatch<sw::manual_clock, sw::packed_storage, sw::atomic_sync>),
+	(sw::basic_stopwatch<sw::manual_clock, sw::packed_storage, sw::seqlock_sync, sw::lap_histogram>),
+	(sw::basic_stopwatch<sw::manual_clock, sw::lap_accumulator, sw::atomic_sync, sw::packed_storage>)) {
+
+	sw::manual_clock::reset();
+
+	auto timer = TestType();
+
+	REQUIRE(timer.is_paused());
+	REQUIRE((timer.get_elapsed() == 0ms));
+
+	// Idle
+	REQUIRE((timer.start() == 0ms));
+	REQUIRE(!timer.is_paused());
+
+	sw::manual_clock::advance(10ms);
+	REQUIRE((timer.get_elapsed() == 10ms));
+
+	// Paused time isn't counted, and pausing twice changes nothing
+	timer.pause();
+	sw::manual_clock::advance(100ms);
+	timer.pause();
+
+	REQUIRE(timer.is_paused());
+	REQUIRE((timer.get_elapsed() == 10ms));
+
+	// Resuming returns the time so far
+	REQUIRE((timer.start() == 10ms));
+
+	sw::manual_clock::advance(5ms);
+	REQUIRE((timer.template get_elapsed<std::chrono::microseconds>() == 15ms));
+
+	// Restarting a running stopwatch is a lap
+	REQUIRE((timer.start() == 15ms));
+
+	sw::manual_clock::advance(1ms);
+	REQUIRE((timer.get_elapsed() == 1ms));
+
+	// The time of a restart can be given, instead of reading the clock
+	const auto now = sw::manual_clock::now();
+
+	sw::manual_clock::advance(2ms);
+	REQUIRE((timer.start(now) == 1ms));
+	REQUIRE((timer.get_elapsed() == 2ms));
+
+	timer.reset();
+
+	REQUIRE(timer.is_paused());
+	REQUIRE((timer.get_elapsed() == 0ms));
+}
+
+TEST_CASE("Stopwatch laps policies") {
+	sw::manual_clock::reset();
+
+	SECTION("Histogram") {
+		auto timer = sw::basic_stopwatch<sw::manual_clock, sw::lap_histogram>();
+
+		timer.start();
+
+		for (int i{ 1 }; i <= 4; i++) {
+			sw::manual_clock::advance(std::chrono::milliseconds(i));
+			timer.start();
+		}
+
+		REQUIRE(timer.laps().count() == 4);
+		REQUIRE(timer.laps().min() == 1ms);
+		REQUIRE(timer.laps().max() == 4ms);
+		REQUIRE(timer.laps().sum() == 10ms);
+
+		// Resuming a paused stopwatch isn't a lap
+		timer.pause();
+		sw::manual_clock::advance(1s);
+		timer.start();
+
+		REQUIRE(timer.laps().count() == 4);
+
+		timer.reset();
+
+		REQUIRE(timer.laps().count() == 0);
+	}
+
+	SECTION("Accumulator with a seqlock") {
+		auto timer = sw::basic_stopwatch<sw::manual_clock, sw::lap_accumulator, sw::seqlock_sync>();
+
+		timer.start();
+
+		sw::manual_clock::advance(2ms);
+		timer.start();
+		sw::manual_clock::advance(4ms);
+		timer.start();
+
+		REQUIRE(timer.laps().count() == 2);
+		REQUIRE(timer.laps().mean() == 3ms);
+	}
+}
+
+TEST_CASE("Packed stopwatch with times before the epoch") {
+	sw::manual_clock::reset();
+
+	auto timer = sw::basic_stopwatch<negative_clock, sw::packed_storage>();
+
+	timer.start();
+	sw::manual_clock::advance(3ms);
+
+	REQUIRE((timer.get_elapsed() == 3ms));
+
+	timer.pause();
+
+	REQUIRE((timer.get_elapsed() == 3ms));
+}
+
+TEMPLATE_TEST_CASE("Synchronized stopwatches are shared by threads", "",
+	(sw::basic_stopwatch<std::chrono::steady_clock, sw::packed_storage, sw::atomic_sync, sw::lap_histogram>),
+	(sw::basic_stopwatch<std::chrono::steady_clock, sw::seqlock_sync, sw::lap_histogram>)) {
+
+	constexpr int threads	= 4;
+	constexpr int laps		= 10'000;
+
+	auto timer		= TestType();
+	auto workers	= std::vector<std::thread>();
+	auto negative	= std::atomic<int>();
+
+	timer.start();
+
+	// Catch isn't thread safe, so the threads only count what's wrong
+	for (int t{}; t < threads; t++) {
+		workers.emplace_back([&] {
+			for (int i{}; i < laps; i++) {
+				if (timer.start() < 0ns) negative++;
+				if (timer.get_elapsed() < 0ns) negative++;
+			}
+		});
+	}
+
+	for (auto& w : workers) w.join();
+
+	// Every restart was a lap, and none was lost or torn
+	REQUIRE(negative == 0);
+	REQUIRE(timer.laps().count() == threads * laps);
+	REQUIRE(!timer.is_paused());
+}
\ No newline at end of file
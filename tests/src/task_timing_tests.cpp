@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "task_timing.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::literals::chrono_literals;
+
+using test_task_timing = sw::basic_task_timing<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Task queue delay and run time") {
+	sw::manual_clock::reset();
+
+	auto timing	= test_task_timing(1);
+	auto task	= timing.wrap([] { sw::manual_clock::advance(2ms); });
+
+	sw::manual_clock::advance(5ms);
+	task();
+
+	auto s = timing.stats();
+
+	REQUIRE(s.queue_delay.count() == 1);
+	REQUIRE(s.queue_delay.max() == 5ms);
+	REQUIRE(s.run_time.count() == 1);
+	REQUIRE(s.run_time.max() == 2ms);
+
+	timing.reset();
+
+	REQUIRE(timing.stats().run_time.count() == 0);
+}
+
+TEST_CASE("Wrapped tasks return the result of the task") {
+	auto timing = test_task_timing(1);
+
+	REQUIRE(timing.wrap([] { return 42; })() == 42);
+
+	// It fits in a std::function
+	auto f = std::function<int()>(timing.wrap([] { return 7; }));
+
+	REQUIRE(f() == 7);
+	REQUIRE(timing.stats().run_time.count() == 2);
+}
+
+TEST_CASE("Tasks that throw are recorded") {
+	sw::manual_clock::reset();
+
+	auto timing = test_task_timing(1);
+	auto task	= timing.wrap([] {
+		sw::manual_clock::advance(3ms);
+		throw std::runtime_error("test");
+	});
+
+	REQUIRE_THROWS_AS(task(), std::runtime_error);
+	REQUIRE(timing.stats().run_time.max() == 3ms);
+}
+
+TEST_CASE("Workers record into their own slots") {
+	auto timing = test_task_timing(2);
+
+	auto worker = [&](std::size_t index, int tasks) {
+		timing.attach_worker(index);
+
+		for (int i{}; i < tasks; i++) timing.wrap([] {})();
+	};
+
+	auto a = std::thread(worker, 0, 10);
+	auto b = std::thread(worker, 1, 20);
+
+	a.join();
+	b.join();
+
+	// Unattached threads and out of range indices use the shared slot
+	timing.wrap([] {})();
+	std::thread(worker, 5, 3).join();
+
+	REQUIRE(timing.worker_stats(0).run_time.count() == 10);
+	REQUIRE(timing.worker_stats(1).run_time.count() == 20);
+	REQUIRE(timing.worker_stats(2).run_time.count() == 4);
+	REQUIRE(timing.stats().run_time.count() == 34);
+}
+
+TEST_CASE("Attaching to one instance doesn't affect another") {
+	auto first	= test_task_timing(1);
+	auto second	= test_task_timing(1);
+
+	first.attach_worker(0);
+
+	first.wrap([] {})();
+	second.wrap([] {})();
+
+	REQUIRE(first.worker_stats(0).run_time.count() == 1);
+	REQUIRE(second.worker_stats(0).run_time.count() == 0);
+	REQUIRE(second.worker_stats(1).run_time.count() == 1);
+}
\ No newline at end of file
@@ -1,7 +1,7 @@
-#define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
 #include "stopwatch.hpp"
+#include "manual_clock.hpp"
 
 using namespace std::literals::chrono_literals;
 
@@ -18,6 +18,7 @@ static_assert(!sw::detail::is_chrono_duration_v<int>);
 static_assert( sw::detail::is_ratio_v<std::ratio<1>>);
 static_assert(!sw::detail::is_ratio_v<int>);
 static_assert( sw::detail::is_trivial_clock_v<std::chrono::steady_clock>);
+static_assert( sw::detail::is_trivial_clock_v<sw::manual_clock>);
 // static_assert(!sw::detail::is_trivial_clock_v<int>);
 
 
@@ -110,51 +111,98 @@ void static_test_5() {
 	static_assert(sw::convert_time<sw::d_seconds>(-1s)			== std::chrono::duration_cast<sw::d_seconds>(-1s));
 }
 
+// A disabled stopwatch is an empty type that can be used entirely at compile time, so it can't read the clock
+constexpr auto use_disabled_stopwatch() {
+	auto timer = sw::disabled_stopwatch();
+
+	timer.start();
+	timer.pause();
+	timer.start<std::chrono::milliseconds>();
+	timer.reset();
+
+	return timer.get_elapsed<sw::duration_components>().nanoseconds + timer.get_elapsed<std::chrono::nanoseconds>().count() + timer.get_elapsed().count();
+}
+
+void static_test_6() {
+	static_assert(std::is_empty_v<sw::disabled_stopwatch>);
+	static_assert(sizeof(sw::disabled_stopwatch) == 1);
+	static_assert(std::is_trivially_copyable_v<sw::disabled_stopwatch>);
+	static_assert(std::is_trivially_destructible_v<sw::disabled_stopwatch>);
+
+	static_assert(use_disabled_stopwatch() == 0);
+	static_assert(sw::disabled_stopwatch().is_paused());
+	static_assert(sw::disabled_stopwatch().get_elapsed<sw::d_seconds>() == sw::d_seconds::zero());
+
+	// Same interface, same result types
+	static_assert(std::is_same_v<decltype(sw::disabled_stopwatch().get_elapsed()), decltype(sw::stopwatch().get_elapsed())>);
+	static_assert(std::is_same_v<decltype(sw::disabled_stopwatch().start<sw::duration_components>()), decltype(sw::stopwatch().start<sw::duration_components>())>);
+
+	// Disabled whatever the other policies are
+	static_assert(std::is_empty_v<sw::basic_stopwatch<sw::manual_clock, sw::split_storage, sw::disabled, sw::no_laps>>);
+
+	// Both sides of the switch, whichever one this build uses
+	static_assert(std::is_same_v<sw::detail::instrumentation_stopwatch_t<std::chrono::steady_clock, false>, sw::disabled_stopwatch>);
+	static_assert(std::is_same_v<sw::detail::instrumentation_stopwatch_t<std::chrono::steady_clock, true>, sw::stopwatch>);
+
+#ifdef SW_DISABLE_INSTRUMENTATION
+	static_assert(std::is_same_v<sw::instrumentation_stopwatch, sw::disabled_stopwatch>);
+#else
+	static_assert(std::is_same_v<sw::instrumentation_stopwatch, sw::stopwatch>);
+#endif
+}
+
 
 
 // ========================= Test cases
 
 
 
-#include <thread>
+// All of these use sw::manual_clock, so the results are exact and nothing actually has to wait.
+using test_stopwatch = sw::basic_stopwatch<sw::manual_clock>;
 
 TEST_CASE("start() when idle and running + multiple start() calls") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t1 = timer.start();
 	auto t2 = timer.start();
 
-	REQUIRE((t1 > 50ms && t1 < 150ms));
-	REQUIRE((t2 < 50ms));
+	REQUIRE((t1 == 100ms));
+	REQUIRE((t2 == 0ms));
 }
 
 TEST_CASE("pause() + start() when paused + multiple start() calls") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	timer.pause();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t1 = timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t2 = timer.start();
 
-	REQUIRE((t1 > 50ms && t1 < 150ms));
-	REQUIRE((t2 > 150ms && t2 < 250ms));
+	REQUIRE((t1 == 100ms));
+	REQUIRE((t2 == 200ms));
 }
 
 TEST_CASE("is_paused()") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	auto ret1 = timer.is_paused();
 
@@ -172,74 +220,145 @@ TEST_CASE("is_paused()") {
 }
 
 TEST_CASE("reset()") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	auto t1 = timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	timer.reset();
 	auto t2 = timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	timer.pause();
 	timer.reset();
 	auto t3 = timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t4 = timer.start();
 
-	REQUIRE((t1 >= t2));
-	REQUIRE((t2 == t3));
-	REQUIRE((t4 > 50ms && t4 < 150ms));
+	REQUIRE((t1 == 0ms));
+	REQUIRE((t2 == 0ms));
+	REQUIRE((t3 == 0ms));
+	REQUIRE((t4 == 100ms));
 }
 
 TEST_CASE("get_elapsed()") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t1 = timer.get_elapsed();
 	auto t2 = timer.get_elapsed();
 
-	REQUIRE((t1 > 50ms && t1 < 150ms));
-	REQUIRE((t2 >= t1));
-	REQUIRE(((t2 - t1) < 50ms));
+	sw::manual_clock::advance(1ns);
+
+	auto t3 = timer.get_elapsed();
+
+	REQUIRE((t1 == 100ms));
+	REQUIRE((t2 == t1));
+	REQUIRE((t3 == 100ms + 1ns));
 }
 
 TEST_CASE("Multiple pause() calls") {
-	auto timer = sw::stopwatch();
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
 
 	timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t1 = timer.get_elapsed();
 
 	timer.pause();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t2 = timer.get_elapsed();
 
 	timer.pause();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
 
 	auto t3 = timer.get_elapsed();
 
 	timer.start();
 
-	std::this_thread::sleep_for(100ms);
+	sw::manual_clock::advance(100ms);
+
+	auto t4 = timer.get_elapsed();
+
+	REQUIRE((t1 == 100ms));
+	REQUIRE((t2 == 100ms));
+	REQUIRE((t3 == 100ms));
+	REQUIRE((t4 == 200ms));
+}
+
+TEST_CASE("Templated start() and get_elapsed()") {
+	sw::manual_clock::reset();
+
+	auto timer = test_stopwatch();
+
+	timer.start();
+
+	sw::manual_clock::advance(1s + 2ms + 3us);
+
+	auto t1 = timer.get_elapsed<std::chrono::milliseconds>();
+	auto t2 = timer.get_elapsed<sw::duration_components>();
+	auto t3 = timer.start<sw::d_microseconds>();
+
+	REQUIRE((t1 == 1002ms));
+	REQUIRE(t2.seconds == 1);
+	REQUIRE(t2.milliseconds == 2);
+	REQUIRE(t2.microseconds == 3);
+	REQUIRE((t3 == 1002003us));
+}
+
+TEST_CASE("sw::stopwatch with the real clock") {
+	auto timer = sw::stopwatch();
+
+	timer.start();
+
+	auto t1 = timer.get_elapsed();
+	auto t2 = timer.get_elapsed();
+
+	timer.pause();
 
+	auto t3 = timer.get_elapsed();
 	auto t4 = timer.get_elapsed();
 
-	REQUIRE((t1 > 50ms && t1 < 150ms));
-	REQUIRE((t2 > 50ms && t2 < 150ms));
-	REQUIRE((t3 == t2));
-	REQUIRE((t4 > t3));
+	REQUIRE((t1 >= 0ms));
+	REQUIRE((t2 >= t1));
+	REQUIRE((t3 >= t2));
+	REQUIRE((t4 == t3));
+}
+
+TEST_CASE("Disabled stopwatch") {
+	sw::manual_clock::reset();
+
+	auto timer = sw::basic_disabled_stopwatch<sw::manual_clock>();
+
+	REQUIRE(timer.is_paused());
+
+	timer.start();
+	sw::manual_clock::advance(1s);
+
+	REQUIRE(timer.is_paused());
+	REQUIRE((timer.get_elapsed() == 0ms));
+	REQUIRE((timer.start() == 0ms));
+	REQUIRE(timer.get_elapsed<sw::duration_components>().seconds == 0);
+
+	timer.pause();
+	timer.reset();
+
+	REQUIRE((timer.get_elapsed<sw::d_milliseconds>() == 0ms));
 }
\ No newline at end of file
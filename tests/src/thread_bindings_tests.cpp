@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include "thread_bindings.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+struct test_slot {
+	int					value{};
+	std::atomic<bool>	alive{ true };
+};
+
+using test_bindings = sw::detail::thread_bindings<test_slot>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Thread bindings are per instance and per thread") {
+	auto a = test_bindings();
+	auto b = test_bindings();
+
+	REQUIRE(a.find() == nullptr);
+
+	auto slot = std::make_shared<test_slot>();
+	a.bind(slot);
+
+	REQUIRE(a.find() == slot.get());
+	REQUIRE(b.find() == nullptr);
+
+	// Other threads have their own bindings
+	const test_slot* seen = slot.get();
+	std::thread([&] { seen = a.find(); }).join();
+
+	REQUIRE(seen == nullptr);
+
+	// Binding again replaces the slot, and marks the old one dead
+	auto replacement = std::make_shared<test_slot>();
+	a.bind(replacement);
+
+	REQUIRE(a.find() == replacement.get());
+	REQUIRE(!slot->alive);
+}
+
+TEST_CASE("Thread bindings mark the slots of exiting threads dead") {
+	auto bindings	= test_bindings();
+	auto slot		= std::make_shared<test_slot>();
+
+	std::thread([&] { bindings.bind(slot); }).join();
+
+	REQUIRE(!slot->alive);
+	REQUIRE(slot.use_count() == 1);
+}
+
+TEST_CASE("Thread bindings to destroyed instances are dropped") {
+	auto slot		= std::make_shared<test_slot>();
+	auto weak		= std::weak_ptr<test_slot>(slot);
+	auto finished	= std::atomic<bool>();
+	auto destroyed	= std::atomic<bool>();
+
+	{
+		auto bindings = std::make_unique<test_bindings>();
+
+		// The thread that destroys the instance drops its binding right away
+		bindings->bind(std::move(slot));
+		bindings.reset();
+
+		REQUIRE(weak.expired());
+	}
+
+	// Other threads drop theirs on their next lookup
+	auto bindings	= std::make_unique<test_bindings>();
+	auto other		= test_bindings();
+	auto other_slot	= std::make_shared<test_slot>();
+	weak			= other_slot;
+
+	auto thread = std::thread([&] {
+		bindings->bind(std::move(other_slot));
+		finished = true;
+
+		while (!destroyed) std::this_thread::yield();
+
+		(void)other.find();
+		finished = false;
+	});
+
+	while (!finished) std::this_thread::yield();
+
+	bindings.reset();
+	REQUIRE(!weak.expired());
+
+	destroyed = true;
+	while (finished) std::this_thread::yield();
+
+	REQUIRE(weak.expired());
+
+	thread.join();
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include "ticker.hpp"
+#include "manual_clock.hpp"
+
+using namespace std::literals::chrono_literals;
+
+// Jumps the manual clock to the requested time, plus some made up wake-up latency
+struct manual_wait {
+	sw::manual_clock::duration* latency;
+
+	void operator()(sw::manual_clock::time_point t) const noexcept {
+		sw::manual_clock::set(t + *latency);
+	}
+};
+
+using test_ticker = sw::basic_ticker<sw::manual_clock, manual_wait>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("ticker doesn't drift") {
+	sw::manual_clock::reset();
+
+	auto latency	= sw::manual_clock::duration(3ms);
+	auto t			= test_ticker(10ms, sw::missed_tick_policy::skip, manual_wait{ &latency });
+	auto epoch		= t.epoch();
+
+	for (int i{}; i < 1000; i++) {
+		REQUIRE(t.wait() == 0);
+
+		// Simulating some work after each tick
+		sw::manual_clock::advance(1ms);
+	}
+
+	// A lap timer that's restarted after each wake-up would be 4 seconds behind by now
+	REQUIRE(t.ticks() == 1000);
+	REQUIRE((t.next_tick_time() == epoch + 1001 * 10ms));
+	REQUIRE(t.lateness().count() == 1000);
+	REQUIRE(t.lateness().mean() == 3ms);
+	REQUIRE(t.lateness().max() == 3ms);
+}
+
+TEST_CASE("ticker with missed_tick_policy::skip") {
+	sw::manual_clock::reset();
+
+	auto latency	= sw::manual_clock::duration(0ms);
+	auto t			= test_ticker(10ms, sw::missed_tick_policy::skip, manual_wait{ &latency });
+	auto epoch		= t.epoch();
+
+	t.wait();
+
+	// Stalling for 4.5 periods
+	sw::manual_clock::advance(45ms);
+
+	REQUIRE(t.wait() == 3);
+	REQUIRE(t.skipped() == 3);
+	REQUIRE(t.ticks() == 5);
+	REQUIRE(t.lateness().max() == 5ms);
+	REQUIRE((sw::manual_clock::now() == epoch + 55ms));
+
+	REQUIRE(t.wait() == 0);
+	REQUIRE((sw::manual_clock::now() == epoch + 60ms));
+}
+
+TEST_CASE("ticker with missed_tick_policy::catch_up") {
+	sw::manual_clock::reset();
+
+	auto latency	= sw::manual_clock::duration(0ms);
+	auto t			= test_ticker(10ms, sw::missed_tick_policy::catch_up, manual_wait{ &latency });
+	auto epoch		= t.epoch();
+
+	t.wait();
+
+	sw::manual_clock::advance(45ms);
+
+	// Ticks 2 to 5 are delivered right away, tick 6 is waited for
+	for (int i{}; i < 4; i++) REQUIRE(t.wait() == 0);
+
+	REQUIRE((sw::manual_clock::now() == epoch + 55ms));
+	REQUIRE(t.lateness().max() == 35ms);
+
+	t.wait();
+
+	REQUIRE((sw::manual_clock::now() == epoch + 60ms));
+	REQUIRE(t.ticks() == 6);
+	REQUIRE(t.skipped() == 0);
+
+	t.reset();
+
+	REQUIRE(t.ticks() == 0);
+	REQUIRE(t.lateness().count() == 0);
+	REQUIRE((t.next_tick_time() == epoch + 70ms));
+}
+
+TEST_CASE("ticker with the real clock") {
+	auto t		= sw::ticker<>(2ms);
+	auto timer	= sw::stopwatch();
+
+	timer.start();
+
+	for (int i{}; i < 5; i++) t.wait();
+
+	REQUIRE(timer.get_elapsed() >= 10ms);
+	REQUIRE(t.lateness().min() >= 0ms);
+}
\ No newline at end of file
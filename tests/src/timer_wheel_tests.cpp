@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include "timer_wheel.hpp"
+#include "manual_clock.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+using test_wheel = sw::basic_timer_wheel<sw::manual_clock, int>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("timer_wheel expires timers in order and never early") {
+	sw::manual_clock::reset();
+
+	auto wheel		= test_wheel(1ms);
+	auto expired	= std::vector<int>();
+	auto collect	= [&](int payload) { expired.push_back(payload); };
+
+	wheel.schedule_after(3ms, 3);
+	wheel.schedule_after(1ms, 1);
+	wheel.schedule_after(2500us, 2);
+	wheel.schedule_after(0ms, 0);
+
+	REQUIRE(wheel.size() == 4);
+	REQUIRE(wheel.advance(collect) == 1);
+	REQUIRE(expired == std::vector<int>{ 0 });
+
+	sw::manual_clock::advance(2ms);
+
+	REQUIRE(wheel.advance(collect) == 1);
+
+	sw::manual_clock::advance(999us);
+
+	REQUIRE(wheel.advance(collect) == 0);
+
+	sw::manual_clock::advance(1us);
+
+	// These two round up to the same tick, so they come in the order they were scheduled
+	REQUIRE(wheel.advance(collect) == 2);
+	REQUIRE(expired == std::vector<int>{ 0, 1, 3, 2 });
+	REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timer_wheel cancel()") {
+	sw::manual_clock::reset();
+
+	auto wheel	= test_wheel(1ms);
+	int sum{};
+
+	auto a = wheel.schedule_after(5ms, 1);
+	auto b = wheel.schedule_after(5h, 10);
+	wheel.schedule_after(5ms, 100);
+
+	REQUIRE(wheel.cancel(a));
+	REQUIRE(!wheel.cancel(a));
+	REQUIRE(wheel.cancel(b));
+	REQUIRE(wheel.size() == 1);
+
+	// The freed slot gets reused, which must not make the old ID valid again
+	auto c = wheel.schedule_after(5ms, 1000);
+
+	REQUIRE(!wheel.cancel(a));
+
+	sw::manual_clock::advance(10ms);
+	wheel.advance([&](int payload) { sum += payload; });
+
+	REQUIRE(sum == 1100);
+	REQUIRE(!wheel.cancel(c));
+}
+
+TEST_CASE("timer_wheel with far deadlines") {
+	sw::manual_clock::reset();
+
+	auto wheel		= test_wheel(1ms);
+	auto expired	= std::vector<int>();
+
+	// Beyond the range of the wheel (2^26 ticks)
+	wheel.schedule_after(30h, 30);
+	wheel.schedule_after(17h, 17);
+
+	for (int h = 1; h <= 40; h++) {
+		sw::manual_clock::advance(1h - 1ms);
+		wheel.advance([&](int payload) { expired.push_back(payload); REQUIRE(false); });
+		sw::manual_clock::advance(1ms);
+		wheel.advance([&](int payload) { expired.push_back(payload); REQUIRE(payload == h); });
+	}
+
+	REQUIRE(expired == std::vector<int>{ 17, 30 });
+}
+
+TEST_CASE("timer_wheel matches a reference with random timers") {
+	sw::manual_clock::reset();
+
+	auto wheel		= test_wheel(1us);
+	auto rng		= std::mt19937(42);
+	auto deadlines	= std::vector<sw::manual_clock::time_point>();
+	auto expired	= std::vector<bool>();
+	auto ids		= std::vector<test_wheel::timer_id>();
+
+	for (int i{}; i < 20000; i++) {
+		deadlines.push_back(sw::manual_clock::now() + std::chrono::microseconds(rng() % (1u << 22)));
+		ids.push_back(wheel.schedule_at(deadlines.back(), i));
+		expired.push_back(false);
+	}
+
+	for (int i{}; i < 20000; i += 7) {
+		REQUIRE(wheel.cancel(ids[i]));
+		expired[i] = true;
+	}
+
+	auto last = sw::manual_clock::now();
+
+	while (!wheel.empty()) {
+		sw::manual_clock::advance(std::chrono::microseconds(rng() % 5000));
+
+		auto now = sw::manual_clock::now();
+
+		wheel.advance([&](int i) {
+			REQUIRE(!expired[i]);
+			REQUIRE((deadlines[i] <= now));
+			REQUIRE((deadlines[i] > last));
+			expired[i] = true;
+		});
+
+		last = now;
+	}
+
+	for (bool e : expired) REQUIRE(e);
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include "timing_stats.hpp"
+
+#include <limits>
+
+using namespace std::literals::chrono_literals;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("duration_accumulator") {
+	auto acc = sw::duration_accumulator();
+
+	REQUIRE(acc.count() == 0);
+	REQUIRE(acc.min() == 0ms);
+	REQUIRE(acc.max() == 0ms);
+
+	for (auto d : { 2ms, 4ms, 4ms, 4ms, 5ms, 5ms, 7ms, 9ms }) acc.record(d);
+
+	REQUIRE(acc.count() == 8);
+	REQUIRE(acc.sum() == 40ms);
+	REQUIRE(acc.min() == 2ms);
+	REQUIRE(acc.max() == 9ms);
+	REQUIRE(acc.mean() == 5ms);
+	REQUIRE(acc.stddev().count() == Approx(2.138090e6));
+}
+
+TEST_CASE("duration_accumulator merge()") {
+	auto all	= sw::duration_accumulator();
+	auto a		= sw::duration_accumulator();
+	auto b		= sw::duration_accumulator();
+	auto empty	= sw::duration_accumulator();
+
+	for (int i = 1; i <= 100; i++) {
+		auto d = std::chrono::microseconds(i * i % 37);
+
+		all.record(d);
+		(i < 30 ? a : b).record(d);
+	}
+
+	a.merge(b);
+	a.merge(empty);
+	empty.merge(a);
+
+	for (auto& m : { a, empty }) {
+		REQUIRE(m.count() == all.count());
+		REQUIRE(m.min() == all.min());
+		REQUIRE(m.max() == all.max());
+		REQUIRE(m.sum().count() == Approx(all.sum().count()));
+		REQUIRE(m.mean().count() == Approx(all.mean().count()));
+		REQUIRE(m.stddev().count() == Approx(all.stddev().count()));
+	}
+
+	a.reset();
+
+	REQUIRE(a.count() == 0);
+}
+
+TEST_CASE("duration_histogram bucket boundaries") {
+	using h = sw::duration_histogram;
+
+	for (std::size_t i{}; i + 1 < h::bucket_count; i++) {
+		REQUIRE(h::bucket_upper_bound(i) == h::bucket_lower_bound(i + 1));
+		REQUIRE(h::bucket_index(h::bucket_lower_bound(i)) == i);
+		REQUIRE(h::bucket_index(h::bucket_upper_bound(i) - 1) == i);
+	}
+
+	REQUIRE(h::bucket_index(0) == 0);
+	REQUIRE(h::bucket_index(15) == 15);
+	REQUIRE(h::bucket_index(16) == 16);
+	REQUIRE(h::bucket_index(std::numeric_limits<std::int64_t>::max()) < h::bucket_count);
+}
+
+TEST_CASE("duration_histogram quantiles") {
+	auto hist = sw::duration_histogram();
+
+	REQUIRE(hist.quantile(0.5) == 0ns);
+
+	for (int i = 1; i <= 1000; i++) hist.record(std::chrono::microseconds(i));
+
+	REQUIRE(hist.count() == 1000);
+	REQUIRE(hist.min() == 1us);
+	REQUIRE(hist.max() == 1000us);
+	REQUIRE(hist.mean().count() == Approx(500.5e3));
+	REQUIRE(hist.quantile(0.0) == 1us);
+	REQUIRE(hist.quantile(1.0) == 1000us);
+
+	for (double q : { 0.1, 0.5, 0.9, 0.99 }) {
+		REQUIRE(hist.quantile(q).count() == Approx(q * 1e6).epsilon(1.0 / 16));
+	}
+
+	auto other = sw::duration_histogram();
+
+	other.record(5s, 1000);
+	other.record(-1s);
+	hist.merge(other);
+
+	REQUIRE(hist.count() == 2001);
+	REQUIRE(hist.min() == 0ns);
+	REQUIRE(hist.max() == 5s);
+	REQUIRE(hist.quantile(0.75).count() == Approx(5e9).epsilon(1.0 / 16));
+
+	hist.reset();
+
+	REQUIRE(hist.count() == 0);
+	REQUIRE(hist.max() == 0ns);
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "tracing.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+using test_tracer = sw::basic_tracer<sw::manual_clock>;
+
+// Keeps every exported span, and how many batches they came in.
+struct span_collector {
+	std::vector<sw::span_record>	spans;
+	int								batches{};
+
+	auto sink() {
+		return [this](const std::vector<sw::span_record>& batch) {
+			spans.insert(spans.end(), batch.begin(), batch.end());
+			batches++;
+		};
+	}
+
+	const sw::span_record& find(const std::string& name) const {
+		for (const auto& s : spans) {
+			if (s.name == name) return s;
+		}
+
+		FAIL("No span named " << name);
+		return spans.front();
+	}
+};
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Tracer records parent and child spans") {
+	sw::manual_clock::reset();
+
+	auto collector	= span_collector();
+	auto tracer		= test_tracer(collector.sink());
+
+	const auto start = sw::manual_clock::now();
+
+	{
+		auto request = tracer.start_span("request");
+
+		REQUIRE(request.is_sampled());
+		REQUIRE(request.context().valid());
+
+		sw::manual_clock::advance(10ms);
+
+		{
+			auto query = request.child("query");
+
+			sw::manual_clock::advance(5ms);
+			query.timer().pause();
+			sw::manual_clock::advance(100ms);
+		}
+
+		sw::manual_clock::advance(10ms);
+	}
+
+	REQUIRE(collector.spans.empty());
+
+	tracer.flush();
+
+	REQUIRE(collector.spans.size() == 2);
+	REQUIRE(tracer.exported() == 2);
+
+	const auto& request	= collector.find("request");
+	const auto& query	= collector.find("query");
+
+	REQUIRE(request.parent_id == 0);
+	REQUIRE(request.duration_ns == std::chrono::nanoseconds(125ms).count());
+	REQUIRE(request.start_ns == std::chrono::nanoseconds(start.time_since_epoch()).count());
+	REQUIRE(request.thread == std::this_thread::get_id());
+
+	REQUIRE(query.trace_id == request.trace_id);
+	REQUIRE(query.parent_id == request.span_id);
+	REQUIRE(query.span_id != request.span_id);
+	REQUIRE(query.duration_ns == std::chrono::nanoseconds(5ms).count());
+	REQUIRE(query.start_ns == std::chrono::nanoseconds(start.time_since_epoch() + 10ms).count());
+
+	// Every trace gets its own id
+	{
+		auto other = tracer.start_span("other");
+		REQUIRE(other.context().trace_id != request.trace_id);
+	}
+}
+
+TEST_CASE("Tracer spans are ended once") {
+	sw::manual_clock::reset();
+
+	auto collector	= span_collector();
+	auto tracer		= test_tracer(collector.sink());
+
+	{
+		auto span = tracer.start_span("early");
+
+		sw::manual_clock::advance(1ms);
+		span.end();
+		sw::manual_clock::advance(1ms);
+		span.end();
+	}
+
+	tracer.flush();
+
+	REQUIRE(collector.spans.size() == 1);
+	REQUIRE(collector.spans[0].duration_ns == std::chrono::nanoseconds(1ms).count());
+}
+
+TEST_CASE("Tracer context propagates to other threads") {
+	sw::manual_clock::reset();
+
+	auto collector	= span_collector();
+	auto tracer		= test_tracer(collector.sink());
+
+	auto worker_thread = std::thread::id();
+
+	{
+		auto request = tracer.start_span("request");
+
+		// Only the context crosses the thread boundary
+		std::thread([&, context = request.context()] {
+			auto work = tracer.start_span("work", context);
+			worker_thread = std::this_thread::get_id();
+		}).join();
+	}
+
+	// The spans of the thread that exited are exported too
+	tracer.flush();
+
+	REQUIRE(collector.spans.size() == 2);
+
+	const auto& request	= collector.find("request");
+	const auto& work	= collector.find("work");
+
+	REQUIRE(work.trace_id == request.trace_id);
+	REQUIRE(work.parent_id == request.span_id);
+	REQUIRE(work.thread == worker_thread);
+
+	// Without a valid context, a new trace starts
+	{
+		auto orphan = tracer.start_span("orphan", sw::span_context());
+		REQUIRE(orphan.context().valid());
+		REQUIRE(orphan.context().trace_id != request.trace_id);
+	}
+}
+
+TEST_CASE("Tracer head sampling") {
+	sw::manual_clock::reset();
+
+	SECTION("Nothing is recorded with a rate of 0") {
+		auto collector	= span_collector();
+		auto tracer		= test_tracer(collector.sink(), 0.0);
+
+		{
+			auto root	= tracer.start_span("root");
+			auto child	= root.child("child");
+
+			REQUIRE(!root.is_sampled());
+			REQUIRE(!child.is_sampled());
+
+			// Unsampled traces still have ids, so their context can be propagated
+			REQUIRE(root.context().valid());
+			REQUIRE(child.context().trace_id == root.context().trace_id);
+		}
+
+		tracer.flush();
+
+		REQUIRE(collector.spans.empty());
+		REQUIRE(collector.batches == 0);
+	}
+
+	SECTION("Children follow the decision of the root") {
+		constexpr int traces = 10'000;
+
+		auto collector	= span_collector();
+		auto tracer		= test_tracer(collector.sink(), 0.25);
+
+		int sampled{};
+
+		for (int i{}; i < traces; i++) {
+			auto root	= tracer.start_span("root");
+			auto child	= root.child("child");
+
+			REQUIRE(child.is_sampled() == root.is_sampled());
+
+			if (root.is_sampled()) sampled++;
+		}
+
+		tracer.flush();
+
+		REQUIRE(sampled > traces * 20 / 100);
+		REQUIRE(sampled < traces * 30 / 100);
+		REQUIRE(collector.spans.size() == static_cast<std::size_t>(sampled) * 2);
+	}
+
+	SECTION("The rate is clamped") {
+		REQUIRE(test_tracer(nullptr, 2.0).sample_rate() == 1.0);
+		REQUIRE(test_tracer(nullptr, -1.0).sample_rate() == 0.0);
+	}
+}
+
+TEST_CASE("Tracer exports in batches") {
+	sw::manual_clock::reset();
+
+	auto collector = span_collector();
+
+	{
+		auto tracer = test_tracer(collector.sink(), 1.0, 3);
+
+		for (int i{}; i < 7; i++) auto span = tracer.start_span("span");
+
+		// Full batches are exported right away
+		REQUIRE(collector.batches == 2);
+		REQUIRE(collector.spans.size() == 6);
+	}
+
+	// The rest is exported when the tracer is destroyed
+	REQUIRE(collector.batches == 3);
+	REQUIRE(collector.spans.size() == 7);
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include "manual_clock.hpp"
+#include "watchdog.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals::chrono_literals;
+
+using test_watchdog = sw::basic_watchdog<sw::manual_clock>;
+
+
+
+// ========================= Test cases
+
+
+
+TEST_CASE("Watchdog reports sections over their threshold once") {
+	sw::manual_clock::reset();
+
+	auto events	= std::vector<sw::watchdog_event>();
+	auto wd		= test_watchdog(0ms, [&](const sw::watchdog_event& e) { events.push_back(e); });
+
+	{
+		auto s = wd.watch("handler", 500ms);
+
+		sw::manual_clock::advance(500ms);
+		REQUIRE(wd.scan() == 0);
+		REQUIRE(s.get_elapsed() == 500ms);
+
+		// Noticed while the section is still running
+		sw::manual_clock::advance(100ms);
+		REQUIRE(wd.scan() == 1);
+		REQUIRE(events.size() == 1);
+		REQUIRE(std::string(events[0].name) == "handler");
+		REQUIRE(events[0].elapsed == 600ms);
+		REQUIRE(events[0].threshold == 500ms);
+		REQUIRE(events[0].thread == std::this_thread::get_id());
+
+		sw::manual_clock::advance(1s);
+		REQUIRE(wd.scan() == 0);
+	}
+
+	// Finished sections are never reported
+	{
+		auto s = wd.watch("short", 500ms);
+		sw::manual_clock::advance(100ms);
+	}
+
+	sw::manual_clock::advance(1s);
+	REQUIRE(wd.scan() == 0);
+
+	// A new section in the same slot is reported again
+	{
+		auto s = wd.watch("handler", 500ms);
+		sw::manual_clock::advance(1s);
+		REQUIRE(wd.scan() == 1);
+	}
+
+	REQUIRE(events.size() == 2);
+}
+
+TEST_CASE("Watchdog with nested sections") {
+	sw::manual_clock::reset();
+
+	auto names	= std::vector<std::string>();
+	auto wd		= test_watchdog(0ms, [&](const sw::watchdog_event& e) { names.push_back(e.name); });
+
+	auto outer = wd.watch("outer", 1s);
+
+	{
+		auto inner = wd.watch("inner", 100ms);
+		sw::manual_clock::advance(200ms);
+		REQUIRE(wd.scan() == 1);
+	}
+
+	sw::manual_clock::advance(1s);
+	REQUIRE(wd.scan() == 1);
+
+	REQUIRE(names == std::vector<std::string>{ "inner", "outer" });
+}
+
+TEST_CASE("Watchdog sees sections on other threads") {
+	sw::manual_clock::reset();
+
+	std::atomic<int> reported{};
+	auto entered	= std::atomic<bool>();
+	auto release	= std::atomic<bool>();
+	auto wd			= test_watchdog(0ms, [&](const sw::watchdog_event&) { reported++; });
+
+	auto worker = std::thread([&] {
+		auto s = wd.watch("worker", 10ms);
+		entered = true;
+		while (!release) std::this_thread::yield();
+	});
+
+	while (!entered) std::this_thread::yield();
+
+	REQUIRE(wd.threads() == 1);
+
+	sw::manual_clock::advance(20ms);
+	REQUIRE(wd.scan() == 1);
+
+	release = true;
+	worker.join();
+
+	// The slot of the exited thread is dropped by the next scan
+	REQUIRE(wd.scan() == 0);
+	REQUIRE(wd.threads() == 0);
+	REQUIRE(reported == 1);
+}
+
+TEST_CASE("Watchdog background thread") {
+	auto reported	= std::atomic<bool>();
+	auto wd			= sw::watchdog(1ms, [&](const sw::watchdog_event&) { reported = true; });
+
+	auto s		= wd.watch("slow", 5ms);
+	auto timer	= sw::stopwatch();
+
+	timer.start();
+
+	while (!reported && timer.get_elapsed() < 10s) std::this_thread::sleep_for(1ms);
+
+	REQUIRE(reported);
+	REQUIRE(s.get_elapsed() >= 5ms);
+}
\ No newline at end of file
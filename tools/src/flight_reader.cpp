@@ -0,0 +1,91 @@
+// Decodes a flight recorder file (see inc/flight_recorder.hpp) into text, or into the Chrome trace event format, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// Usage: flight_reader <file> [--json]
+
+#include "flight_recorder.hpp"
+
+#include <cstdio>
+#include <ctime>
+#include <map>
+
+static void print_text(const sw::flight_recording& r) {
+	std::printf("%llu events recorded, %zu still in the file\n\n", static_cast<unsigned long long>(r.recorded), r.events.size());
+	std::printf("%-26s %14s %14s %8s  %s\n", "start (UTC)", "offset ms", "duration us", "thread", "name");
+
+	// Threads are numbered in the order they first appear
+	auto threads = std::map<std::uint64_t, std::size_t>();
+
+	for (const auto& e : r.events) {
+		const auto system_ns	= r.to_system_ns(e.start_ns);
+		const auto seconds		= static_cast<std::time_t>(system_ns / 1'000'000'000);
+		const auto thread		= threads.emplace(e.thread, threads.size()).first->second;
+
+		char date[32]{};
+		std::tm utc{};
+
+#ifdef _WIN32
+		gmtime_s(&utc, &seconds);
+#else
+		gmtime_r(&seconds, &utc);
+#endif
+		std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &utc);
+
+		std::printf("%s.%06lld %14.3f %14.3f %8zu  %s\n",
+			date,
+			static_cast<long long>(system_ns % 1'000'000'000 / 1000),
+			static_cast<double>(e.start_ns - r.clock_anchor_ns) / 1e6,
+			static_cast<double>(e.duration_ns) / 1e3,
+			thread,
+			e.name.c_str());
+	}
+}
+
+static void print_json_string(const std::string& s) {
+	std::putchar('"');
+
+	for (const char c : s) {
+		if (c == '"' || c == '\\') std::printf("\\%c", c);
+		else if (static_cast<unsigned char>(c) < 0x20) std::printf("\\u%04x", static_cast<unsigned>(c));
+		else std::putchar(c);
+	}
+
+	std::putchar('"');
+}
+
+// Complete events ("ph": "X"), with times in microseconds from the creation of the file
+static void print_json(const sw::flight_recording& r) {
+	auto threads = std::map<std::uint64_t, std::size_t>();
+
+	std::printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	for (std::size_t i{}; i < r.events.size(); i++) {
+		const auto& e		= r.events[i];
+		const auto thread	= threads.emplace(e.thread, threads.size()).first->second;
+
+		std::printf("%s\n{\"name\":", i ? "," : "");
+		print_json_string(e.name);
+		std::printf(",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+			thread,
+			static_cast<double>(e.start_ns - r.clock_anchor_ns) / 1e3,
+			static_cast<double>(e.duration_ns) / 1e3);
+	}
+
+	std::printf("\n]}\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[2]) != "--json")) {
+		std::fprintf(stderr, "Usage: %s <file> [--json]\n", argv[0]);
+		return 2;
+	}
+
+	try {
+		const auto recording = sw::read_flight_recording(argv[1]);
+
+		if (argc == 3) print_json(recording);
+		else print_text(recording);
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+// Prints the metrics that a running process publishes through sw::shm_metrics_registry (see inc/shm_metrics.hpp). Without a segment name, lists the metrics segments that exist (only on Linux, where they live in /dev/shm).
+//
+// Usage: metrics_reader [<segment> [-w <seconds>]]
+//   -w <seconds>     Print the metrics again every this many seconds, until interrupted
+
+#include "shm_metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <filesystem>
+#endif
+
+static int list_segments() {
+#ifdef __linux__
+	auto found = 0;
+
+	for (const auto& entry : std::filesystem::directory_iterator("/dev/shm")) {
+		char magic[sizeof(sw::detail::shm_magic)]{};
+
+		auto file = std::ifstream(entry.path(), std::ios::binary);
+
+		if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, sw::detail::shm_magic, sizeof(magic)) != 0) continue;
+
+		try {
+			const auto name		= entry.path().filename().string();
+			const auto reader	= sw::shm_metrics_reader(name);
+
+			std::printf("%-40s pid %-10llu %zu metrics\n", name.c_str(), static_cast<unsigned long long>(reader.pid()), reader.read().size());
+			found++;
+		} catch (const std::exception& e) {
+			std::printf("%-40s %s\n", entry.path().filename().string().c_str(), e.what());
+		}
+	}
+
+	if (found == 0) std::printf("No metrics segments found\n");
+
+	return 0;
+#else
+	std::fprintf(stderr, "Listing segments is only supported on Linux\n");
+	return 2;
+#endif
+}
+
+static void print_metrics(const sw::shm_metrics_reader& reader) {
+	const auto us = [](auto d) { return sw::convert_time<sw::d_microseconds>(d).count(); };
+
+	std::printf("pid %llu\n", static_cast<unsigned long long>(reader.pid()));
+	std::printf("%-32s %-11s %12s %12s %12s %12s %12s %12s   (us)\n", "name", "kind", "count", "mean", "min", "p50", "p99", "max");
+
+	for (const auto& m : reader.read()) {
+		if (m.kind == sw::shm_metric_kind::accumulator) {
+			const auto& a = m.accumulator;
+
+			std::printf("%-32s %-11s %12llu %12.3f %12.3f %12s %12s %12.3f\n",
+				m.name.c_str(), "accumulator",
+				static_cast<unsigned long long>(a.count()),
+				us(a.mean()), us(a.min()), "-", "-", us(a.max()));
+		} else {
+			const auto& h = m.histogram;
+
+			std::printf("%-32s %-11s %12llu %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+				m.name.c_str(), "histogram",
+				static_cast<unsigned long long>(h.count()),
+				us(h.mean()), us(h.min()), us(h.quantile(0.5)), us(h.quantile(0.99)), us(h.max()));
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc == 1) return list_segments();
+
+	if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "-w")) {
+		std::fprintf(stderr, "Usage: %s [<segment> [-w <seconds>]]\n", argv[0]);
+		return 2;
+	}
+
+	try {
+		const auto reader = sw::shm_metrics_reader(argv[1]);
+
+		if (argc == 2) {
+			print_metrics(reader);
+			return 0;
+		}
+
+		const auto interval = std::chrono::seconds(std::max(1, std::atoi(argv[3])));
+
+		while (true) {
+			print_metrics(reader);
+			std::printf("\n");
+			std::fflush(stdout);
+			std::this_thread::sleep_for(interval);
+		}
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
\ No newline at end of file